@@ -0,0 +1,305 @@
+#include "platform/hash.h"
+#include "platform/mm.h"
+#include "mgb/emulator.h"
+#include "mgb/movie.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BATCH_DEFAULT_FRAMES 60
+
+enum batch_option_type {
+	BATCH_OPTION_JOBS,
+	BATCH_OPTION_CYCLES,
+	BATCH_OPTION_FRAMES,
+	BATCH_OPTION_COPIES,
+	BATCH_OPTION_FAST,
+	BATCH_OPTION_MOVIE,
+};
+
+struct batch_option {
+	const char *description;
+	const char *l;
+	const char *s;
+	const int length;
+	enum batch_option_type type;
+};
+
+struct batch_instance {
+	char *rom_path;
+	int status;
+	u64 frames;
+	u64 cycles;
+	u64 instructions;
+	u64 hash;
+	double elapsed;
+	u32 verified;
+	s64 diverged;
+};
+
+struct batch {
+	struct batch_instance *instances;
+	int count;
+	int next;
+	pthread_mutex_t lock;
+
+	int jobs;
+	u64 cycles;
+	u64 frames;
+	bool fast;
+	char *movie_path;
+	struct profile profile; // Sum over the instances
+};
+
+// clang-format off
+static const struct batch_option options[] = {
+	{ "-j/--jobs <int>     Number of worker threads", "--jobs", "-j", 1, BATCH_OPTION_JOBS },
+	{ "-c/--cycles <int>   Run each instance for a number of M-cycles", "--cycles", "-c", 1, BATCH_OPTION_CYCLES },
+	{ "-F/--frames <int>   Run each instance for a number of frames", "--frames", "-F", 1, BATCH_OPTION_FRAMES },
+	{ "-n/--copies <int>   Number of instances of every ROM", "--copies", "-n", 1, BATCH_OPTION_COPIES },
+	{ "-f/--fast           Execute whole instructions per step", "--fast", "-f", 0, BATCH_OPTION_FAST },
+	{ "-m/--movie <path>   Replay and verify a movie in every instance", "--movie", "-m", 1, BATCH_OPTION_MOVIE },
+};
+// clang-format on
+
+static double elapsed_since(struct timespec *start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) +
+	       (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static u64 hash_frame_buffer(const u8 *frame_buffer)
+{
+	return hash_fnv1a(FNV_OFFSET_BASIS, frame_buffer, GB_WIDTH * GB_HEIGHT);
+}
+
+static bool movie_running(struct gb_emulator *gb)
+{
+	return gb->movie && !gb->movie->ended;
+}
+
+static void run_instance(struct batch *batch, struct batch_instance *instance)
+{
+	struct gb_emulator *gb;
+	struct timespec start;
+	struct movie movie;
+
+	if (!(gb = mgb_create(instance->rom_path))) {
+		instance->status = -1;
+		return;
+	}
+	if (batch->movie_path) {
+		if (movie_replay(&movie, gb, batch->movie_path)) {
+			instance->status = -1;
+			mgb_destroy(gb);
+			return;
+		}
+		gb->movie = &movie;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (batch->cycles) {
+		while (gb->cpu.cycles < batch->cycles)
+			gb_run_until(gb, batch->cycles, batch->fast);
+	} else if (!batch->frames) {
+		// Until the end of the movie
+		while (movie_running(gb))
+			gb_run_until(gb, ~0ULL, batch->fast);
+	} else {
+		// Frames are only counted while the LCD is on, bound the
+		// budget in cycles for ROMs that keep it off
+		u64 limit = (batch->frames + 1) * GB_VIDEO_FRAME_PERIOD;
+		while (gb->gpu.frames < batch->frames && gb->cpu.cycles < limit)
+			gb_run_until(gb, limit, batch->fast);
+	}
+	instance->elapsed = elapsed_since(&start);
+	instance->frames = gb->gpu.frames;
+	instance->cycles = gb->cpu.cycles;
+	instance->instructions = gb->cpu.instructions;
+	instance->hash = hash_frame_buffer(mgb_get_framebuffer(gb));
+	instance->diverged = -1;
+	if (gb->movie) {
+		instance->verified = movie.verified;
+		instance->diverged = movie.diverged;
+		movie_close(&movie);
+	}
+	pthread_mutex_lock(&batch->lock);
+	profile_merge(&batch->profile, &gb->profile);
+	pthread_mutex_unlock(&batch->lock);
+	mgb_destroy(gb);
+}
+
+static void *run_worker_thread(void *arg)
+{
+	struct batch *batch = arg;
+	int index;
+
+	for (;;) {
+		pthread_mutex_lock(&batch->lock);
+		index = batch->next++;
+		pthread_mutex_unlock(&batch->lock);
+		if (index >= batch->count)
+			break;
+		run_instance(batch, &batch->instances[index]);
+	}
+	pthread_exit(NULL);
+}
+
+static int run_batch(struct batch *batch)
+{
+	pthread_t *threads;
+
+	threads = calloc(batch->jobs, sizeof(pthread_t));
+	if (!threads)
+		return -1;
+	for (int i = 0; i < batch->jobs; i++)
+		pthread_create(&threads[i], NULL, run_worker_thread, batch);
+	for (int i = 0; i < batch->jobs; i++)
+		pthread_join(threads[i], NULL);
+	zfree(threads);
+	return 0;
+}
+
+static int print_report(struct batch *batch, double elapsed)
+{
+	u64 frames = 0;
+	u64 instructions = 0;
+	int failures = 0;
+
+	for (int i = 0; i < batch->count; i++) {
+		struct batch_instance *instance = &batch->instances[i];
+		if (instance->status) {
+			printf("%4d %s failed to load ROM or movie\n", i,
+			       instance->rom_path);
+			failures++;
+			continue;
+		}
+		if (instance->diverged >= 0) {
+			printf("%4d %s diverged from the movie at frame %ld\n",
+			       i, instance->rom_path, instance->diverged);
+			failures++;
+		}
+		printf("%4d %s frames=%lu instructions=%lu cycles=%lu "
+		       "fps=%.1f hash=%016lx\n",
+		       i, instance->rom_path, instance->frames,
+		       instance->instructions, instance->cycles,
+		       instance->frames / instance->elapsed, instance->hash);
+		frames += instance->frames;
+		instructions += instance->instructions;
+	}
+	printf("Instances: %d Jobs: %d Failures: %d\n", batch->count,
+	       batch->jobs, failures);
+	printf("Frames: %lu Instructions: %lu Elapsed: %.3fs fps=%.1f\n",
+	       frames, instructions, elapsed, frames / elapsed);
+#ifdef MGB_PROFILE
+	profile_print(&batch->profile, stdout);
+#endif
+	return failures;
+}
+
+static void print_help()
+{
+	printf("usage: mgb-batch [ARGS] <rom>...\n");
+	for (int i = 0; i < ARRAY_SIZE(options); i++)
+		printf("   %s\n", options[i].description);
+}
+
+static int parse_option(struct batch *batch, int *copies, int i, int argc,
+			char **argv)
+{
+	for (int j = 0; j < ARRAY_SIZE(options); j++) {
+		if (strcmp(argv[i], options[j].l) &&
+		    strcmp(argv[i], options[j].s)) {
+			continue;
+		}
+		if (i + options[j].length >= argc)
+			return -1;
+		switch (options[j].type) {
+		case BATCH_OPTION_JOBS:
+			batch->jobs = atoi(argv[i + 1]);
+			break;
+		case BATCH_OPTION_CYCLES:
+			batch->cycles = strtoull(argv[i + 1], NULL, 0);
+			break;
+		case BATCH_OPTION_FRAMES:
+			batch->frames = strtoull(argv[i + 1], NULL, 0);
+			break;
+		case BATCH_OPTION_COPIES:
+			*copies = atoi(argv[i + 1]);
+			break;
+		case BATCH_OPTION_FAST:
+			batch->fast = true;
+			break;
+		case BATCH_OPTION_MOVIE:
+			batch->movie_path = argv[i + 1];
+			break;
+		}
+		return options[j].length;
+	}
+	return -1;
+}
+
+static int batch_create(struct batch *batch, int argc, char **argv)
+{
+	char **roms;
+	int count = 0;
+	int copies = 1;
+
+	memset(batch, 0, sizeof(struct batch));
+	batch->jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	if (!(roms = calloc(argc, sizeof(char *))))
+		return -1;
+	for (int i = 1; i < argc; i++) {
+		int length = 0;
+		if (argv[i][0] != '-')
+			roms[count++] = argv[i];
+		else if ((length = parse_option(batch, &copies, i, argc,
+						argv)) < 0)
+			goto err;
+		i += length;
+	}
+	if (!count || copies < 1 || batch->jobs < 1)
+		goto err;
+	if (!batch->cycles && !batch->frames && !batch->movie_path)
+		batch->frames = BATCH_DEFAULT_FRAMES;
+	batch->count = count * copies;
+	batch->instances = calloc(batch->count, sizeof(struct batch_instance));
+	if (!batch->instances)
+		goto err;
+	for (int i = 0; i < batch->count; i++)
+		batch->instances[i].rom_path = roms[i / copies];
+	if (batch->jobs > batch->count)
+		batch->jobs = batch->count;
+	pthread_mutex_init(&batch->lock, NULL);
+	zfree(roms);
+	return 0;
+err:
+	zfree(roms);
+	return -1;
+}
+
+int main(int argc, char **argv)
+{
+	struct batch batch;
+	struct timespec start;
+	int failures;
+
+	if (batch_create(&batch, argc, argv)) {
+		print_help();
+		return 1;
+	}
+	profile_reset(&batch.profile);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (run_batch(&batch)) {
+		printf("failed to start workers\n");
+		return 1;
+	}
+	failures = print_report(&batch, elapsed_since(&start));
+	pthread_mutex_destroy(&batch.lock);
+	zfree(batch.instances);
+	return failures ? 1 : 0;
+}
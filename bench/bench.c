@@ -0,0 +1,268 @@
+#include "platform/hash.h"
+#include "platform/mm.h"
+#include "mgb/emulator.h"
+#include "workload.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Build options, reported so compared runs can be told apart
+#ifdef SM83_COMPUTED_GOTO
+#define BENCH_DISPATCH "goto"
+#else
+#define BENCH_DISPATCH "switch"
+#endif
+#ifdef SM83_LAZY_FLAGS
+#define BENCH_FLAGS "lazy"
+#else
+#define BENCH_FLAGS "eager"
+#endif
+#ifdef MGB_PROFILE
+#define BENCH_PROFILE "true"
+#else
+#define BENCH_PROFILE "false"
+#endif
+
+// About 712 frames per run
+#define BENCH_DEFAULT_CYCLES 50000000
+#define BENCH_DEFAULT_RUNS 3
+
+enum bench_option_type {
+	BENCH_OPTION_CYCLES,
+	BENCH_OPTION_RUNS,
+	BENCH_OPTION_FAST,
+	BENCH_OPTION_OUTPUT,
+	BENCH_OPTION_WORKLOAD,
+};
+
+struct bench_option {
+	const char *description;
+	const char *l;
+	const char *s;
+	const int length;
+	enum bench_option_type type;
+};
+
+struct bench {
+	u64 cycles;
+	int runs;
+	bool fast;
+	const char *output;
+	const char *workload; // Only run this one when set
+};
+
+struct bench_result {
+	u64 cycles;
+	u64 instructions;
+	u64 frames;
+	u64 hash;
+	double elapsed;
+};
+
+// clang-format off
+static const struct bench_option options[] = {
+	{ "-c/--cycles <int>     Run each workload for a number of cycles", "--cycles", "-c", 1, BENCH_OPTION_CYCLES },
+	{ "-r/--runs <int>       Runs per workload, the median is reported", "--runs", "-r", 1, BENCH_OPTION_RUNS },
+	{ "-f/--fast             Execute whole instructions per step", "--fast", "-f", 0, BENCH_OPTION_FAST },
+	{ "-o/--output <dir>     Directory of the assembled ROMs", "--output", "-o", 1, BENCH_OPTION_OUTPUT },
+	{ "-w/--workload <name>  Only run this workload", "--workload", "-w", 1, BENCH_OPTION_WORKLOAD },
+};
+// clang-format on
+
+static double elapsed_since(struct timespec *start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) +
+	       (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int run_workload(struct bench *bench, const char *path,
+			struct bench_result *result, struct profile *profile)
+{
+	struct gb_emulator *gb;
+	struct timespec start;
+
+	if (!(gb = mgb_create(path)))
+		return -1;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while (gb->cpu.cycles < bench->cycles)
+		gb_run_until(gb, bench->cycles, bench->fast);
+	result->elapsed = elapsed_since(&start);
+	result->cycles = gb->cpu.cycles;
+	result->instructions = gb->cpu.instructions;
+	result->frames = gb->gpu.frames;
+	result->hash = hash_fnv1a(FNV_OFFSET_BASIS, mgb_get_framebuffer(gb),
+				  GB_WIDTH * GB_HEIGHT);
+	profile_merge(profile, &gb->profile);
+	mgb_destroy(gb);
+	return 0;
+}
+
+static int compare_elapsed(const void *a, const void *b)
+{
+	double x = ((const struct bench_result *)a)->elapsed;
+	double y = ((const struct bench_result *)b)->elapsed;
+	return (x > y) - (x < y);
+}
+
+static void print_result(const struct workload *workload,
+			 struct bench_result *result, bool last)
+{
+	double elapsed = result->elapsed;
+
+	printf("    {\n");
+	printf("      \"name\": \"%s\",\n", workload->name);
+	printf("      \"cycles\": %lu,\n", result->cycles);
+	printf("      \"instructions\": %lu,\n", result->instructions);
+	printf("      \"frames\": %lu,\n", result->frames);
+	printf("      \"seconds\": %.6f,\n", elapsed);
+	printf("      \"mhz\": %.3f,\n", result->cycles / elapsed / 1e6);
+	printf("      \"fps\": %.1f,\n", result->frames / elapsed);
+	printf("      \"ns_per_instruction\": %.2f,\n",
+	       result->instructions ? elapsed * 1e9 / result->instructions :
+				      0);
+	printf("      \"hash\": \"%016lx\"\n", result->hash);
+	printf("    }%s\n", last ? "" : ",");
+}
+
+// Assemble the workload and keep the median run
+static int bench_workload(struct bench *bench,
+			  const struct workload *workload,
+			  struct bench_result *median)
+{
+	struct bench_result *results;
+	struct profile profile;
+	struct rom rom;
+	char path[PATH_MAX];
+
+	rom_init(&rom);
+	workload->assemble(&rom);
+	snprintf(path, sizeof(path), "%s/%s.gb", bench->output,
+		 workload->name);
+	if (rom_write(&rom, path)) {
+		fprintf(stderr, "failed to write %s\n", path);
+		return -1;
+	}
+	if (!(results = calloc(bench->runs, sizeof(struct bench_result))))
+		return -1;
+	profile_reset(&profile);
+	for (int i = 0; i < bench->runs; i++) {
+		if (run_workload(bench, path, &results[i], &profile)) {
+			fprintf(stderr, "failed to load %s\n", path);
+			zfree(results);
+			return -1;
+		}
+	}
+	qsort(results, bench->runs, sizeof(struct bench_result),
+	      compare_elapsed);
+	*median = results[bench->runs / 2];
+	zfree(results);
+#ifdef MGB_PROFILE
+	// Keep stdout for the JSON report
+	fprintf(stderr, "%s, all runs\n", workload->name);
+	profile_print(&profile, stderr);
+#endif
+	return 0;
+}
+
+static void print_help()
+{
+	printf("usage: mgb-bench [ARGS]\n");
+	for (int i = 0; i < ARRAY_SIZE(options); i++)
+		printf("   %s\n", options[i].description);
+	printf("Workloads:\n");
+	for (int i = 0; i < workload_count; i++)
+		printf("   %-8s %s\n", workloads[i].name,
+		       workloads[i].description);
+}
+
+static int parse_option(struct bench *bench, int i, int argc, char **argv)
+{
+	for (int j = 0; j < ARRAY_SIZE(options); j++) {
+		if (strcmp(argv[i], options[j].l) &&
+		    strcmp(argv[i], options[j].s)) {
+			continue;
+		}
+		if (i + options[j].length >= argc)
+			return -1;
+		switch (options[j].type) {
+		case BENCH_OPTION_CYCLES:
+			bench->cycles = strtoull(argv[i + 1], NULL, 0);
+			break;
+		case BENCH_OPTION_RUNS:
+			bench->runs = atoi(argv[i + 1]);
+			break;
+		case BENCH_OPTION_FAST:
+			bench->fast = true;
+			break;
+		case BENCH_OPTION_OUTPUT:
+			bench->output = argv[i + 1];
+			break;
+		case BENCH_OPTION_WORKLOAD:
+			bench->workload = argv[i + 1];
+			break;
+		}
+		return options[j].length;
+	}
+	return -1;
+}
+
+static int bench_create(struct bench *bench, int argc, char **argv)
+{
+	int length;
+
+	memset(bench, 0, sizeof(struct bench));
+	bench->cycles = BENCH_DEFAULT_CYCLES;
+	bench->runs = BENCH_DEFAULT_RUNS;
+	bench->output = ".";
+	for (int i = 1; i < argc; i++) {
+		if ((length = parse_option(bench, i, argc, argv)) < 0)
+			return -1;
+		i += length;
+	}
+	if (!bench->cycles || bench->runs < 1)
+		return -1;
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct bench bench;
+	struct bench_result result;
+	int last = -1;
+
+	if (bench_create(&bench, argc, argv)) {
+		print_help();
+		return 1;
+	}
+	for (int i = 0; i < workload_count; i++) {
+		if (!bench.workload || !strcmp(bench.workload, workloads[i].name))
+			last = i;
+	}
+	if (last < 0) {
+		print_help();
+		return 1;
+	}
+	printf("{\n");
+	printf("  \"cycles\": %lu,\n", bench.cycles);
+	printf("  \"runs\": %d,\n", bench.runs);
+	printf("  \"fast\": %s,\n", bench.fast ? "true" : "false");
+	printf("  \"dispatch\": \"%s\",\n", BENCH_DISPATCH);
+	printf("  \"flags\": \"%s\",\n", BENCH_FLAGS);
+	printf("  \"profile\": %s,\n", BENCH_PROFILE);
+	printf("  \"workloads\": [\n");
+	for (int i = 0; i <= last; i++) {
+		if (bench.workload && strcmp(bench.workload, workloads[i].name))
+			continue;
+		if (bench_workload(&bench, &workloads[i], &result))
+			return 1;
+		print_result(&workloads[i], &result, i == last);
+		fflush(stdout);
+	}
+	printf("  ]\n");
+	printf("}\n");
+	return 0;
+}
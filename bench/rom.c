@@ -0,0 +1,75 @@
+#include "rom.h"
+#include <stdio.h>
+#include <string.h>
+
+// Cartridge header fields
+#define ROM_TYPE 0x0147
+#define ROM_SIZE_CODE 0x0148
+#define ROM_RAM_SIZE_CODE 0x0149
+
+void rom_init(struct rom *rom)
+{
+	memset(rom->image, 0, sizeof(rom->image));
+	// Entry point jumps over the header, no MBC and no RAM
+	rom_org(rom, ROM_ENTRY);
+	EMIT(rom, OP_NOP, OP_JP_NN, LO(ROM_START), HI(ROM_START));
+	rom->image[ROM_TYPE] = 0;
+	rom->image[ROM_SIZE_CODE] = 0;
+	rom->image[ROM_RAM_SIZE_CODE] = 0;
+	rom_org(rom, ROM_START);
+}
+
+void rom_org(struct rom *rom, u16 addr)
+{
+	rom->pc = addr;
+}
+
+void rom_emit(struct rom *rom, const u8 *bytes, size_t size)
+{
+	for (size_t i = 0; i < size && rom->pc < ROM_SIZE; i++)
+		rom->image[rom->pc++] = bytes[i];
+}
+
+u16 rom_label(struct rom *rom)
+{
+	return rom->pc;
+}
+
+// JR or JR cc to an address within reach
+void rom_jr(struct rom *rom, u8 opcode, u16 target)
+{
+	EMIT(rom, opcode, (u8)(target - (rom->pc + 2)));
+}
+
+void rom_ldh(struct rom *rom, u8 reg, u8 value)
+{
+	EMIT(rom, OP_LD_A_N, value, OP_LDH_N_A, reg);
+}
+
+// Copy size bytes from src to dst, size must not be zero
+void rom_copy(struct rom *rom, u16 dst, u16 src, u16 size)
+{
+	u16 loop;
+
+	EMIT(rom, OP_LD_HL_NN, LO(src), HI(src));
+	EMIT(rom, OP_LD_DE_NN, LO(dst), HI(dst));
+	EMIT(rom, OP_LD_BC_NN, LO(size), HI(size));
+	loop = rom_label(rom);
+	EMIT(rom, OP_LDI_A_HL, OP_LD_DE_A, OP_INC_DE, OP_DEC_BC, OP_LD_A_B,
+	     OP_OR_C);
+	rom_jr(rom, OP_JR_NZ, loop);
+}
+
+int rom_write(struct rom *rom, const char *path)
+{
+	FILE *file;
+	int err = 0;
+
+	if (!(file = fopen(path, "wb")))
+		return -1;
+	if (fwrite(rom->image, sizeof(rom->image), 1, file) != 1)
+		err = -1;
+	if (fclose(file))
+		err = -1;
+	return err;
+}
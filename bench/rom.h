@@ -0,0 +1,99 @@
+#ifndef _BENCH_ROM_H
+#define _BENCH_ROM_H
+
+#include "platform/types.h"
+#include <stddef.h>
+
+#define ROM_SIZE 0x8000
+#define ROM_ENTRY 0x0100
+#define ROM_START 0x0150
+
+// clang-format off
+enum rom_opcode {
+	OP_NOP       = 0x00,
+	OP_LD_BC_NN  = 0x01,
+	OP_INC_BC    = 0x03,
+	OP_INC_B     = 0x04,
+	OP_DEC_B     = 0x05,
+	OP_LD_B_N    = 0x06,
+	OP_RLCA      = 0x07,
+	OP_ADD_HL_BC = 0x09,
+	OP_DEC_BC    = 0x0B,
+	OP_DEC_C     = 0x0D,
+	OP_LD_C_N    = 0x0E,
+	OP_LD_DE_NN  = 0x11,
+	OP_LD_DE_A   = 0x12,
+	OP_INC_DE    = 0x13,
+	OP_JR        = 0x18,
+	OP_ADD_HL_DE = 0x19,
+	OP_LD_A_DE   = 0x1A,
+	OP_JR_NZ     = 0x20,
+	OP_JR_Z      = 0x28,
+	OP_LD_HL_NN  = 0x21,
+	OP_LDI_HL_A  = 0x22,
+	OP_INC_HL    = 0x23,
+	OP_LDI_A_HL  = 0x2A,
+	OP_LD_SP_NN  = 0x31,
+	OP_INC_MHL   = 0x34,
+	OP_INC_A     = 0x3C,
+	OP_LD_A_N    = 0x3E,
+	OP_LD_B_A    = 0x47,
+	OP_LD_L_A    = 0x6F,
+	OP_HALT      = 0x76,
+	OP_LD_A_B    = 0x78,
+	OP_LD_A_L    = 0x7D,
+	OP_ADD_A_B   = 0x80,
+	OP_ADC_A_C   = 0x89,
+	OP_SUB_D     = 0x92,
+	OP_AND_H     = 0xA4,
+	OP_XOR_E     = 0xAB,
+	OP_XOR_H     = 0xAC,
+	OP_OR_C      = 0xB1,
+	OP_OR_L      = 0xB5,
+	OP_POP_BC    = 0xC1,
+	OP_JP_NN     = 0xC3,
+	OP_PUSH_BC   = 0xC5,
+	OP_ADD_A_N   = 0xC6,
+	OP_PREFIX    = 0xCB,
+	OP_RETI      = 0xD9,
+	OP_LDH_N_A   = 0xE0,
+	OP_POP_HL    = 0xE1,
+	OP_PUSH_HL   = 0xE5,
+	OP_AND_N     = 0xE6,
+	OP_LDH_A_N   = 0xF0,
+	OP_POP_AF    = 0xF1,
+	OP_DI        = 0xF3,
+	OP_PUSH_AF   = 0xF5,
+	OP_EI        = 0xFB,
+	OP_CP_N      = 0xFE,
+};
+// clang-format on
+
+// CB prefixed
+#define OP_SWAP_A 0x37
+
+#define LO(word) ((word) & 0xFF)
+#define HI(word) ((word) >> 8)
+
+// A 32KiB ROM only image, assembled one instruction at a time. Only
+// backward relative jumps are needed, loops take the address of their
+// first instruction from rom_label.
+struct rom {
+	u8 image[ROM_SIZE];
+	u16 pc;
+};
+
+void rom_init(struct rom *rom);
+void rom_org(struct rom *rom, u16 addr);
+void rom_emit(struct rom *rom, const u8 *bytes, size_t size);
+u16 rom_label(struct rom *rom);
+void rom_jr(struct rom *rom, u8 opcode, u16 target);
+void rom_ldh(struct rom *rom, u8 reg, u8 value);
+void rom_copy(struct rom *rom, u16 dst, u16 src, u16 size);
+int rom_write(struct rom *rom, const char *path);
+
+#define EMIT(rom, ...)                             \
+	rom_emit(rom, (const u8[]){ __VA_ARGS__ }, \
+		 sizeof((const u8[]){ __VA_ARGS__ }))
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef _BENCH_WORKLOAD_H
+#define _BENCH_WORKLOAD_H
+
+#include "rom.h"
+
+// A synthetic program exercising one part of the emulator, it never
+// ends so it can run for any number of cycles
+struct workload {
+	const char *name;
+	const char *description;
+	void (*assemble)(struct rom *rom);
+};
+
+extern const struct workload workloads[];
+extern const int workload_count;
+
+#endif
@@ -0,0 +1,173 @@
+#include "platform/mm.h"
+#include "platform/types.h"
+#include "mgb/memory.h"
+#include "workload.h"
+
+#define VBLANK_VECTOR 0x0040
+#define STAT_VECTOR 0x0048
+#define VBLANK_HANDLER 0x1000
+#define STAT_HANDLER 0x1100
+#define DATA 0x2000
+#define HRAM 0xFF80
+#define OAM 0xFE00
+#define OAM_ENTRIES 40
+
+#define LCDC_OFF 0x00
+// LCD and background on, tiles at 0x8000
+#define LCDC_BG 0x91
+// Also the window from 0x9C00 and 8x16 objects
+#define LCDC_ALL 0xF7
+
+static void lcd_off(struct rom *rom)
+{
+	rom_ldh(rom, LO(LCDC_LCD), LCDC_OFF);
+}
+
+// Arithmetic and register moves only, the LCD stays off
+static void assemble_alu(struct rom *rom)
+{
+	u16 loop, inner;
+
+	lcd_off(rom);
+	loop = rom_label(rom);
+	EMIT(rom, OP_LD_C_N, 0);
+	inner = rom_label(rom);
+	EMIT(rom, OP_ADD_A_B, OP_ADC_A_C, OP_SUB_D, OP_XOR_E, OP_AND_H,
+	     OP_OR_L, OP_INC_A, OP_RLCA, OP_PREFIX, OP_SWAP_A, OP_LD_B_A,
+	     OP_ADD_HL_DE, OP_INC_DE, OP_PUSH_BC, OP_POP_BC, OP_CP_N, 0x5A,
+	     OP_DEC_C);
+	rom_jr(rom, OP_JR_NZ, inner);
+	rom_jr(rom, OP_JR, loop);
+}
+
+// Block copies from ROM to WRAM, within WRAM and to HRAM
+static void assemble_memcpy(struct rom *rom)
+{
+	u16 loop;
+
+	lcd_off(rom);
+	loop = rom_label(rom);
+	rom_copy(rom, 0xC000, 0x0000, 0x1000);
+	rom_copy(rom, 0xD000, 0xC000, 0x1000);
+	rom_copy(rom, HRAM, 0xD000, 0x7F);
+	rom_jr(rom, OP_JR, loop);
+}
+
+// The core sleeps all frame long, waking up for a short VBlank handler
+static void assemble_halt(struct rom *rom)
+{
+	u16 loop;
+
+	rom_ldh(rom, LO(LCDC_LCD), LCDC_BG);
+	rom_ldh(rom, LO(IF), 0);
+	rom_ldh(rom, LO(IE), 1 << IRQ_VBLANK);
+	EMIT(rom, OP_EI);
+	loop = rom_label(rom);
+	EMIT(rom, OP_HALT, OP_NOP);
+	rom_jr(rom, OP_JR, loop);
+
+	// Count frames in HRAM
+	rom_org(rom, VBLANK_VECTOR);
+	EMIT(rom, OP_PUSH_AF, OP_LDH_A_N, LO(HRAM), OP_INC_A, OP_LDH_N_A,
+	     LO(HRAM), OP_POP_AF, OP_RETI);
+}
+
+// Busy-waits on LY for VBlank then on STAT for its end, interrupts off
+static void assemble_poll(struct rom *rom)
+{
+	u16 loop, wait;
+
+	rom_ldh(rom, LO(LCDC_LCD), LCDC_BG);
+	loop = rom_label(rom);
+	wait = rom_label(rom);
+	EMIT(rom, OP_LDH_A_N, LO(LY_LCD), OP_CP_N, 144);
+	rom_jr(rom, OP_JR_NZ, wait);
+	EMIT(rom, OP_LDH_A_N, LO(SCX), OP_INC_A, OP_LDH_N_A, LO(SCX));
+	wait = rom_label(rom);
+	EMIT(rom, OP_LDH_A_N, LO(STAT_LCD), OP_AND_N, 3, OP_CP_N, 1);
+	rom_jr(rom, OP_JR_Z, wait);
+	rom_jr(rom, OP_JR, loop);
+}
+
+static void assemble_oam(struct rom *rom)
+{
+	rom_org(rom, DATA);
+	for (int i = 0; i < OAM_ENTRIES; i++) {
+		EMIT(rom, 16 + (i * 29) % 144, 8 + (i * 37) % 160, i * 2,
+		     (i & 7) << 4);
+	}
+}
+
+// Busy background, window and 40 tall objects, scrolled every line from
+// the LY=LYC interrupt while the objects move every frame
+static void assemble_ppu(struct rom *rom)
+{
+	u16 loop;
+
+	assemble_oam(rom);
+	rom_org(rom, ROM_START);
+	lcd_off(rom);
+	// Tile data from 0x8000 to 0x97FF
+	EMIT(rom, OP_LD_HL_NN, 0x00, 0x80, OP_LD_BC_NN, 0x00, 0x18);
+	loop = rom_label(rom);
+	EMIT(rom, OP_LD_A_L, OP_XOR_H, OP_LDI_HL_A, OP_DEC_BC, OP_LD_A_B,
+	     OP_OR_C);
+	rom_jr(rom, OP_JR_NZ, loop);
+	// Both tile maps
+	EMIT(rom, OP_LD_HL_NN, 0x00, 0x98, OP_LD_BC_NN, 0x00, 0x08);
+	loop = rom_label(rom);
+	EMIT(rom, OP_LD_A_L, OP_LDI_HL_A, OP_DEC_BC, OP_LD_A_B, OP_OR_C);
+	rom_jr(rom, OP_JR_NZ, loop);
+	rom_copy(rom, OAM, DATA, OAM_ENTRIES * 4);
+	rom_ldh(rom, LO(BGP_BG), 0xE4);
+	rom_ldh(rom, LO(OBP0_OBJ), 0xE4);
+	rom_ldh(rom, LO(OBP1_OBJ), 0x1B);
+	rom_ldh(rom, LO(WY), 96);
+	rom_ldh(rom, LO(WX), 87);
+	rom_ldh(rom, LO(LYC_LY), 0);
+	rom_ldh(rom, LO(STAT_LCD), 0x40);
+	rom_ldh(rom, LO(IF), 0);
+	rom_ldh(rom, LO(IE), 1 << IRQ_VBLANK | 1 << IRQ_LCD);
+	rom_ldh(rom, LO(LCDC_LCD), LCDC_ALL);
+	EMIT(rom, OP_EI);
+	loop = rom_label(rom);
+	EMIT(rom, OP_HALT, OP_NOP);
+	rom_jr(rom, OP_JR, loop);
+
+	rom_org(rom, VBLANK_VECTOR);
+	EMIT(rom, OP_JP_NN, LO(VBLANK_HANDLER), HI(VBLANK_HANDLER));
+	rom_org(rom, STAT_VECTOR);
+	EMIT(rom, OP_JP_NN, LO(STAT_HANDLER), HI(STAT_HANDLER));
+
+	// Scroll vertically, restart the line interrupts and move objects
+	rom_org(rom, VBLANK_HANDLER);
+	EMIT(rom, OP_PUSH_AF, OP_PUSH_HL, OP_PUSH_BC);
+	EMIT(rom, OP_LDH_A_N, LO(SCY), OP_INC_A, OP_LDH_N_A, LO(SCY));
+	rom_ldh(rom, LO(LYC_LY), 0);
+	EMIT(rom, OP_LD_HL_NN, LO(OAM + 1), HI(OAM + 1), OP_LD_B_N,
+	     OAM_ENTRIES);
+	loop = rom_label(rom);
+	EMIT(rom, OP_INC_MHL, OP_LD_A_L, OP_ADD_A_N, 4, OP_LD_L_A,
+	     OP_DEC_B);
+	rom_jr(rom, OP_JR_NZ, loop);
+	EMIT(rom, OP_POP_BC, OP_POP_HL, OP_POP_AF, OP_RETI);
+
+	// Next line and horizontal scroll
+	rom_org(rom, STAT_HANDLER);
+	EMIT(rom, OP_PUSH_AF);
+	EMIT(rom, OP_LDH_A_N, LO(LYC_LY), OP_INC_A, OP_LDH_N_A, LO(LYC_LY));
+	EMIT(rom, OP_LDH_A_N, LO(SCX), OP_INC_A, OP_LDH_N_A, LO(SCX));
+	EMIT(rom, OP_POP_AF, OP_RETI);
+}
+
+// clang-format off
+const struct workload workloads[] = {
+	{ "alu",    "Tight arithmetic loop, LCD off",          assemble_alu },
+	{ "memcpy", "Block copies between ROM, WRAM and HRAM", assemble_memcpy },
+	{ "halt",   "HALT until every VBlank",                 assemble_halt },
+	{ "poll",   "Busy-wait on LY and STAT for VBlank",     assemble_poll },
+	{ "ppu",    "Line scrolling, window and 40 objects",   assemble_ppu },
+};
+// clang-format on
+
+const int workload_count = ARRAY_SIZE(workloads);
@@ -0,0 +1,92 @@
+#ifndef _CARTRIDGE_H
+#define _CARTRIDGE_H
+
+#include "platform/types.h"
+#include "mgb/sm83.h"
+#include <stddef.h>
+
+#define CARTRIDGE_TYPE 0x0147
+#define CARTRIDGE_ROM_SIZE 0x0148
+#define CARTRIDGE_RAM_SIZE 0x0149
+#define CARTRIDGE_ROM_BANK_SIZE 0x4000
+#define CARTRIDGE_RAM_BANK_SIZE 0x2000
+#define CARTRIDGE_RAM_START 0xA000
+#define CARTRIDGE_RTC_REGISTERS 5
+
+enum cartridge_type {
+	ROM_ONLY = 0x00,
+	MBC1 = 0x01,
+	MBC1_RAM = 0x02,
+	MBC1_RAM_BATTERY = 0x03,
+	MBC2 = 0x05,
+	MBC2_BATTERY = 0x06,
+	ROM_RAM_9 = 0x08,
+	ROM_RAM_BATTERY_9 = 0x09,
+	MMM01 = 0x0B,
+	MMM01_RAM = 0x0C,
+	MMM01_RAM_BATTERY = 0x0D,
+	MBC3_TIMER_BATTERY = 0x0F,
+	MBC3_TIMER_RAM_BATTERY_10 = 0x10,
+	MBC3 = 0x11,
+	MBC3_RAM_10 = 0x12,
+	MBC3_RAM_BATTERY_10 = 0x13,
+	MBC5 = 0x19,
+	MBC5_RAM = 0x1A,
+	MBC5_RAM_BATTERY = 0x1B,
+	MBC5_RUMBLE = 0x1C,
+	MBC5_RUMBLE_RAM = 0x1D,
+	MBC5_RUMBLE_RAM_BATTERY = 0x1E,
+	MBC6 = 0x20,
+	MBC7_SENSOR_RUMBLE_RAM_BATTERY = 0x22,
+	POCKET_CAMERA = 0xFC,
+	BANDAI_TAMA5 = 0xFD,
+	HUC3 = 0xFE,
+	HUC1_RAM_BATTERY = 0xFF,
+};
+
+enum cartridge_controller {
+	CONTROLLER_NONE,
+	CONTROLLER_MBC1,
+	CONTROLLER_MBC3,
+	CONTROLLER_MBC5,
+};
+
+// Bank registers as written by the game, the mapped banks are derived
+// from them by cartridge_map
+struct cartridge_registers {
+	bool ram_enabled;
+	u16 rom_bank;
+	u8 ram_bank;
+	u8 mode;
+	u8 rtc[CARTRIDGE_RTC_REGISTERS];
+};
+
+struct cartridge {
+	// Read-only, shared with every instance running the same file
+	u8 *rom;
+	size_t rom_size;
+	bool mapped;
+	u16 rom_banks;
+	u8 *ram;
+	size_t ram_size;
+	u8 ram_banks;
+	enum cartridge_type type;
+	enum cartridge_controller controller;
+	struct cartridge_registers regs;
+
+	// Banks currently present in the page table
+	u8 *rom0;
+	u8 *romx;
+	u8 *sram;
+};
+
+int cartridge_load(struct cartridge *cart, const char *path);
+void cartridge_release(struct cartridge *cart);
+void cartridge_reset(struct cartridge *cart);
+void cartridge_map(struct cartridge *cart, struct sm83_memory *memory,
+		   bool force);
+void cartridge_write(struct cartridge *cart, u16 addr, u8 value);
+u8 cartridge_load_ram(struct cartridge *cart, u16 addr);
+void cartridge_write_ram(struct cartridge *cart, u16 addr, u8 value);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef _EMULATOR_H
+#define _EMULATOR_H
+
+#include "platform/types.h"
+#include "mgb/sm83.h"
+#include "mgb/memory.h"
+#include "mgb/cartridge.h"
+#include "mgb/video.h"
+#include "mgb/timer.h"
+#include "mgb/scheduler.h"
+#include "mgb/snapshot.h"
+#include "mgb/profile.h"
+#include <stdatomic.h>
+
+struct rewind;
+struct movie;
+
+// Everything an emulated Game Boy needs lives in this structure, any
+// number of instances can run in a process, each from a single thread
+struct gb_emulator {
+	u8 keys;
+	atomic_uchar input; // Keys of the host, set from any thread
+
+	struct sm83_core cpu;
+	struct ppu gpu;
+	struct memory memory;
+	struct cartridge cartridge;
+	struct scheduler scheduler;
+	struct dirty_map dirty;
+	struct gb_snapshot *snapshot; // Base of the next incremental snapshot
+	struct profile profile; // Only filled when built with MGB_PROFILE
+	struct rewind *rewind; // Owned by the embedder, NULL when disabled
+	struct movie *movie; // Owned by the embedder, NULL when disabled
+
+	// Frame hook for the embedder, runs on the emulation thread
+	void (*vblank)(struct gb_emulator *gb, void *data);
+	void *vblank_data;
+};
+
+/* emulator.c */
+struct gb_emulator *init_gb_emulator(void);
+void destroy_gb_emulator(struct gb_emulator *gb);
+void gb_reset(struct gb_emulator *gb);
+int gb_load_rom(struct gb_emulator *gb, const char *path);
+void gb_run_events(struct gb_emulator *gb);
+u32 gb_run_until(struct gb_emulator *gb, u64 limit, bool fast);
+
+// Library interface, libmgb does not depend on raylib
+struct gb_emulator *mgb_create(const char *rom_path);
+u64 mgb_run_cycles(struct gb_emulator *gb, u64 cycles);
+const u8 *mgb_get_framebuffer(struct gb_emulator *gb);
+void mgb_set_input(struct gb_emulator *gb, u8 keys);
+void mgb_destroy(struct gb_emulator *gb);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef _FRAME_H
+#define _FRAME_H
+
+#include "platform/types.h"
+#include "mgb/video.h"
+#include <stdatomic.h>
+
+#define FRAME_SLOTS 3
+#define FRAME_FRESH 0x4
+#define FRAME_INDEX 0x3
+
+// Snapshot of the machine taken at VBlank, everything the render thread
+// needs without touching the emulator
+struct frame {
+	u64 number;
+	u64 cycles;
+	u8 lcdc;
+	u8 pixels[GB_HEIGHT * GB_WIDTH];
+	u8 vram[GB_VRAM_SIZE];
+};
+
+// Triple buffer between one producer and one consumer. The producer
+// owns the back slot, the consumer the front slot, and both swap their
+// slot with the middle one, whose index lives in state along with a flag
+// telling whether it holds a frame the consumer has not seen yet.
+struct frame_exchange {
+	struct frame slots[FRAME_SLOTS];
+	atomic_uint state;
+	u8 back;
+	u8 front;
+};
+
+void frame_exchange_init(struct frame_exchange *exchange);
+void frame_exchange_publish(struct frame_exchange *exchange);
+struct frame *frame_exchange_acquire(struct frame_exchange *exchange);
+
+static inline struct frame *frame_exchange_back(struct frame_exchange *exchange)
+{
+	return &exchange->slots[exchange->back];
+}
+
+#endif
@@ -1,4 +1,7 @@
-#include "mgb/mgb.h"
+#ifndef _JOYPAD_H
+#define _JOYPAD_H
+
+#include "mgb/emulator.h"
 #include "platform/types.h"
 
 enum joypad_button {
@@ -14,3 +17,5 @@ enum joypad_button {
 
 u8 update_joypad(struct gb_emulator *gb);
 u8 read_keys(u8 keys, u8 joyp);
+
+#endif
@@ -4,6 +4,10 @@
 #include "platform/types.h"
 
 #define MEMORY_SIZE 0x10000
+#define MEMORY_PAGE_SHIFT 8
+#define MEMORY_PAGE_SIZE (1 << MEMORY_PAGE_SHIFT)
+#define MEMORY_PAGE_COUNT (MEMORY_SIZE >> MEMORY_PAGE_SHIFT)
+#define DMG_BOOT_ROM_SIZE 0x100
 
 enum hardware_register {
 	P1_JOYP = 0xFF00,
@@ -79,51 +83,10 @@ struct memory {
 	u8 ram[MEMORY_SIZE];
 };
 
-enum cartridge_type {
-	ROM_ONLY = 0x00,
-	MBC1,
-	MBC1_RAM,
-	MBC1_RAM_BATTERY,
-	MBC2,
-	MBC2_BATTERY,
-	ROM_RAM_9,
-	ROM_RAM_BATTERY_9,
-	MMM01,
-	MMM01_RAM,
-	MMM01_RAM_BATTERY,
-	MBC3_TIMER_BATTERY,
-	MBC3_TIMER_RAM_BATTERY_10,
-	MBC3,
-	MBC3_RAM_10,
-	MBC3_RAM_BATTERY_10,
-	MBC5,
-	MBC5_RAM,
-	MBC5_RAM_BATTERY,
-	MBC5_RUMBLE,
-	MBC5_RUMBLE_RAM,
-	MBC5_RUMBLE_RAM_BATTERY,
-	MBC6,
-	MBC7_SENSOR_RUMBLE_RAM_BATTERY,
-	POCKET_CAMERA,
-	BANDAI_TAMA5,
-	HUC3,
-	HUC1_RAM_BATTERY,
-};
-
-static const u32 CARTRIDGE_RAM_SIZES[6] = {
-	0, // No RAM
-	0, // Unused
-	8192, // 1 Bank
-	32768, // 4 Banks of 8KiB each
-	131072, // 16 Banks of 8KiB each
-	65536 // 8 Banks of 8KiB each
-};
+extern const u8 dmg_boot_rom[DMG_BOOT_ROM_SIZE];
 
-int load_rom(struct memory *mem, char *path);
 void dump_memory(struct memory *mem);
-void dump_memory_to_file(struct memory *mem, char *filename);
 void print_addr(struct memory *mem, u16 addr);
-void request_interrupt(struct memory *mem, enum sm83_irq number);
 void print_hardware_registers(struct memory *mem);
 
 #endif
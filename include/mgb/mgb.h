@@ -2,12 +2,14 @@
 #define _MGB_H
 
 #include "platform/types.h"
-#include "mgb/sm83.h"
-#include "mgb/memory.h"
-#include "mgb/video.h"
-#include <sys/time.h>
+#include "mgb/emulator.h"
+#include "mgb/frame.h"
+#include "mgb/movie.h"
+#include "mgb/pacing.h"
+#include "mgb/rewind.h"
+#include <signal.h>
 
-#define GB_REALISTIC_CYCLES 16670
+#define GB_REWIND_SECONDS 10
 
 enum gb_option_type {
 	GB_OPTION_DEBUG,
@@ -16,14 +18,19 @@ enum gb_option_type {
 	GB_OPTION_NO_DMA,
 	GB_OPTION_SCALE,
 	GB_OPTION_THROTTLING,
+	GB_OPTION_FAST,
+	GB_OPTION_REWIND,
+	GB_OPTION_RECORD,
+	GB_OPTION_REPLAY,
+	GB_OPTION_SPEED,
 };
 
 enum gb_flags {
 	GB_ON,
 	GB_DEBUG,
 	GB_VIDEO,
-	GB_THROTTLING,
 	GB_DMA,
+	GB_FAST,
 };
 
 #define GB_FLAG(flag) (ctx->flags & (1 << flag)) != 0
@@ -38,45 +45,25 @@ struct gb_option {
 	enum gb_option_type type;
 };
 
-struct gb_emulator {
-	u8 keys;
-
-	struct sm83_core cpu;
-	struct ppu gpu;
-	struct memory memory;
-};
-
 struct gb_context {
 	struct gb_emulator *gb;
+	struct frame_exchange *exchange;
+	struct rewind *rewind;
+	struct movie *movie;
+	char *movie_path;
+	enum movie_mode movie_mode;
 	char *rom_path;
 	u8 flags;
 	int exit_code;
 	int scale;
-	struct timeval start_time;
-	u32 cycles;
-};
-
-// clang-format off
-static const u8 dmg_boot_rom[] = {
-	0x31, 0xfe, 0xff, 0xaf, 0x21, 0xff, 0x9f, 0x32, 0xcb, 0x7c, 0x20, 0xfb, 0x21, 0x26, 0xff, 0x0e,
-	0x11, 0x3e, 0x80, 0x32, 0xe2, 0x0c, 0x3e, 0xf3, 0xe2, 0x32, 0x3e, 0x77, 0x77, 0x3e, 0xfc, 0xe0,
-	0x47, 0x21, 0x04, 0x01, 0xe5, 0x11, 0xcb, 0x00, 0x1a, 0x13, 0xbe, 0x20, 0x6b, 0x23, 0x7d, 0xfe,
-	0x34, 0x20, 0xf5, 0x06, 0x19, 0x78, 0x86, 0x23, 0x05, 0x20, 0xfb, 0x86, 0x20, 0x5a, 0xd1, 0x21,
-	0x10, 0x80, 0x1a, 0xcd, 0xa9, 0x00, 0xcd, 0xaa, 0x00, 0x13, 0x7b, 0xfe, 0x34, 0x20, 0xf3, 0x3e,
-	0x18, 0x21, 0x2f, 0x99, 0x0e, 0x0c, 0x32, 0x3d, 0x28, 0x09, 0x0d, 0x20, 0xf9, 0x11, 0xec, 0xff,
-	0x19, 0x18, 0xf1, 0x67, 0x3e, 0x64, 0x57, 0xe0, 0x42, 0x3e, 0x91, 0xe0, 0x40, 0x04, 0x1e, 0x02,
-	0xcd, 0xbc, 0x00, 0x0e, 0x13, 0x24, 0x7c, 0x1e, 0x83, 0xfe, 0x62, 0x28, 0x06, 0x1e, 0xc1, 0xfe,
-	0x64, 0x20, 0x06, 0x7b, 0xe2, 0x0c, 0x3e, 0x87, 0xe2, 0xf0, 0x42, 0x90, 0xe0, 0x42, 0x15, 0x20,
-	0xdd, 0x05, 0x20, 0x69, 0x16, 0x20, 0x18, 0xd6, 0x3e, 0x91, 0xe0, 0x40, 0x1e, 0x14, 0xcd, 0xbc,
-	0x00, 0xf0, 0x47, 0xee, 0xff, 0xe0, 0x47, 0x18, 0xf3, 0x4f, 0x06, 0x04, 0xc5, 0xcb, 0x11, 0x17,
-	0xc1, 0xcb, 0x11, 0x17, 0x05, 0x20, 0xf5, 0x22, 0x23, 0x22, 0x23, 0xc9, 0x0e, 0x0c, 0xf0, 0x44,
-	0xfe, 0x90, 0x20, 0xfa, 0x0d, 0x20, 0xf7, 0x1d, 0x20, 0xf2, 0xc9, 0xce, 0xed, 0x66, 0x66, 0xcc,
-	0x0d, 0x00, 0x0b, 0x03, 0x73, 0x00, 0x83, 0x00, 0x0c, 0x00, 0x0d, 0x00, 0x08, 0x11, 0x1f, 0x88,
-	0x89, 0x00, 0x0e, 0xdc, 0xcc, 0x6e, 0xe6, 0xdd, 0xdd, 0xd9, 0x99, 0xbb, 0xbb, 0x67, 0x63, 0x6e,
-	0x0e, 0xec, 0xcc, 0xdd, 0xdc, 0x99, 0x9f, 0xbb, 0xb9, 0x33, 0x3e, 0xff, 0xff, 0x3c, 0xe0, 0x50,
+	int rewind_seconds;
+	double speed;
+	struct pacing pacing;
+	volatile sig_atomic_t interrupted;
+	volatile sig_atomic_t rewinding;
 };
-// clang-format on
 
+/* mgb.c */
 int gb_start_emulator(struct gb_context *ctx);
 void gb_stop_emulator(struct gb_context *ctx);
 
@@ -0,0 +1,77 @@
+#ifndef _MOVIE_H
+#define _MOVIE_H
+
+#include "platform/types.h"
+#include "mgb/emulator.h"
+#include <stddef.h>
+#include <stdio.h>
+
+#define MGB_MOVIE_MAGIC 0x4D42474D // "MGBM"
+#define MGB_MOVIE_VERSION 1
+#define MOVIE_CHECKPOINT_FRAMES 60
+#define MOVIE_FLAG_DMA (1 << 0)
+
+enum movie_mode {
+	MOVIE_RECORD,
+	MOVIE_REPLAY,
+};
+
+enum movie_record_type {
+	MOVIE_KEYS,
+	MOVIE_CHECKPOINT,
+	MOVIE_END,
+};
+
+// A movie starts at power on, the hashes of its checkpoints are only
+// comparable with the same save state version. VBlank lands mid
+// instruction, so a movie verifies when replayed with the stepping it was
+// recorded with, whole instructions or M-cycles.
+struct movie_header {
+	u32 magic;
+	u16 version;
+	u16 state_version;
+	u32 interval; // Frames between checkpoints
+	u32 flags;
+	u64 rom_hash;
+};
+
+// Frames are counted in VBlanks since power on. Keys records hold the
+// keys latched from that frame, checkpoints the frame buffer and state
+// hashes before the keys of their frame are latched.
+struct movie_record {
+	u32 frame;
+	u8 type;
+	u8 keys;
+	u16 reserved;
+	u64 frame_hash;
+	u64 state_hash;
+};
+
+struct movie {
+	enum movie_mode mode;
+	u32 frame;
+	u8 keys;
+	u32 interval;
+	u8 *state;
+	size_t state_size;
+
+	// Recording
+	FILE *file;
+
+	// Replay
+	struct movie_record *records;
+	u32 count;
+	u32 next;
+	bool ended;
+	u32 verified;
+	s64 diverged; // First checkpoint that differs, -1 when none
+};
+
+int movie_record(struct movie *movie, struct gb_emulator *gb,
+		 const char *path);
+int movie_replay(struct movie *movie, struct gb_emulator *gb,
+		 const char *path);
+u8 movie_update(struct movie *movie, struct gb_emulator *gb, u8 keys);
+int movie_close(struct movie *movie);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef _PACING_H
+#define _PACING_H
+
+#include "platform/types.h"
+#include <stdatomic.h>
+
+#define PACING_NSEC 1000000000LL
+// Lag after which the deadline restarts from now instead of catching up
+#define PACING_MAX_LAG_FRAMES 4
+
+// Sleeps the emulation thread to an absolute deadline once per emulated
+// frame. Deadlines advance by a fixed period from the previous one, so
+// late wakeups do not accumulate.
+struct pacing {
+	double speed; // Multiple of the hardware speed, 0 is uncapped
+	s64 period; // Nanoseconds per frame at this speed
+	s64 deadline;
+	u64 cycles; // Emulated cycles toward the next frame
+
+	s64 window; // Start of the measure window
+	u64 window_cycles;
+	atomic_uint percent; // Measured speed, read from any thread
+};
+
+void pacing_init(struct pacing *pacing, double speed);
+void pacing_set_speed(struct pacing *pacing, double speed);
+void pacing_update(struct pacing *pacing, u64 cycles);
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef _PROFILE_H
+#define _PROFILE_H
+
+#include "platform/types.h"
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Instrumentation, compiled out unless built with MGB_PROFILE
+ * (make PROFILE=1).
+ *
+ * Time is charged to the innermost zone entered: a memory callback
+ * running inside an instruction counts as memory, not CPU. Ticks come
+ * from the TSC where available and are converted to nanoseconds when
+ * the report is printed.
+ */
+#define PROFILE_DEPTH 16
+#define PROFILE_OPCODES 512
+
+enum profile_zone {
+	PROFILE_CPU,
+	PROFILE_MEMORY,
+	PROFILE_TIMER,
+	PROFILE_PPU,
+	PROFILE_RENDER,
+	PROFILE_HOST,
+	PROFILE_ZONES,
+};
+
+enum profile_region {
+	REGION_ROM,
+	REGION_VRAM,
+	REGION_SRAM,
+	REGION_WRAM,
+	REGION_ECHO,
+	REGION_OAM,
+	REGION_UNUSABLE,
+	REGION_IO,
+	REGION_HRAM,
+	REGION_IE,
+	REGION_COUNT,
+};
+
+// Cycles the core jumped over instead of executing
+enum profile_skip {
+	SKIP_HALT,
+	SKIP_IDLE, // Polling loops
+	SKIP_COUNT,
+};
+
+struct profile {
+	u64 ticks[PROFILE_ZONES];
+	u64 entries[PROFILE_ZONES];
+	u64 opcodes[PROFILE_OPCODES]; // Indexed like sm83_instructions
+	u64 loads[REGION_COUNT]; // CPU and DMA reads, direct pages included
+	u64 writes[REGION_COUNT]; // CPU and DMA writes, direct pages included
+	u64 skipped[SKIP_COUNT];
+
+	u64 mark; // Ticks at the last zone change
+	u8 stack[PROFILE_DEPTH];
+	int depth;
+
+	// Calibration of the ticks against the monotonic clock
+	u64 start_ticks;
+	s64 start_ns;
+};
+
+static inline u64 profile_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+// clang-format off
+static inline enum profile_region profile_region(u16 addr)
+{
+	switch (addr) {
+	case 0x0000 ... 0x7FFF: return REGION_ROM;
+	case 0x8000 ... 0x9FFF: return REGION_VRAM;
+	case 0xA000 ... 0xBFFF: return REGION_SRAM;
+	case 0xC000 ... 0xDFFF: return REGION_WRAM;
+	case 0xE000 ... 0xFDFF: return REGION_ECHO;
+	case 0xFE00 ... 0xFE9F: return REGION_OAM;
+	case 0xFEA0 ... 0xFEFF: return REGION_UNUSABLE;
+	case 0xFF00 ... 0xFF7F: return REGION_IO;
+	case 0xFF80 ... 0xFFFE: return REGION_HRAM;
+	default: return REGION_IE;
+	}
+}
+// clang-format on
+
+// Charge the time since the last change to the current zone
+static inline void profile_charge(struct profile *profile)
+{
+	u64 now = profile_ticks();
+	int top = profile->depth < PROFILE_DEPTH ? profile->depth :
+						   PROFILE_DEPTH;
+
+	if (top)
+		profile->ticks[profile->stack[top - 1]] += now - profile->mark;
+	profile->mark = now;
+}
+
+static inline void profile_enter(struct profile *profile,
+				 enum profile_zone zone)
+{
+	profile_charge(profile);
+	profile->entries[zone]++;
+	if (profile->depth < PROFILE_DEPTH)
+		profile->stack[profile->depth] = zone;
+	profile->depth++;
+}
+
+static inline void profile_leave(struct profile *profile)
+{
+	profile_charge(profile);
+	profile->depth--;
+}
+
+#ifdef MGB_PROFILE
+#define PROFILE_ENTER(profile, zone) profile_enter(profile, zone)
+#define PROFILE_LEAVE(profile) profile_leave(profile)
+#define PROFILE_OPCODE(profile, index) ((profile)->opcodes[index]++)
+#define PROFILE_LOAD(profile, addr) ((profile)->loads[profile_region(addr)]++)
+#define PROFILE_WRITE(profile, addr) \
+	((profile)->writes[profile_region(addr)]++)
+#define PROFILE_SKIP(profile, kind, cycles) \
+	((profile)->skipped[kind] += (cycles))
+#else
+#define PROFILE_ENTER(profile, zone) ((void)0)
+#define PROFILE_LEAVE(profile) ((void)0)
+#define PROFILE_OPCODE(profile, index) ((void)0)
+#define PROFILE_LOAD(profile, addr) ((void)0)
+#define PROFILE_WRITE(profile, addr) ((void)0)
+#define PROFILE_SKIP(profile, kind, cycles) ((void)0)
+#endif
+
+/* profile.c */
+void profile_reset(struct profile *profile);
+void profile_merge(struct profile *dst, const struct profile *src);
+void profile_print(const struct profile *profile, FILE *file);
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef _REWIND_H
+#define _REWIND_H
+
+#include "platform/types.h"
+#include "mgb/emulator.h"
+#include <stddef.h>
+
+#define REWIND_FRAMES_PER_SECOND 60
+
+struct rewind_entry {
+	u32 offset;
+	u32 size;
+};
+
+// History of the states saved at every VBlank. Only the newest state is
+// kept whole, each older one is stored as the run-length encoded XOR
+// with the state that followed it. Records live in a single arena used
+// as a ring, the oldest ones are dropped to make room, so recording a
+// frame never allocates.
+struct rewind {
+	bool pending; // A frame ended since the last record
+	bool valid; // current holds a state
+	size_t state_size;
+	u8 *current;
+	u8 *next;
+	u8 *scratch;
+
+	u8 *arena;
+	size_t arena_size;
+	size_t write;
+
+	struct rewind_entry *entries;
+	u32 capacity;
+	u32 head;
+	u32 count;
+};
+
+int rewind_init(struct rewind *rw, struct gb_emulator *gb, u32 frames,
+		size_t arena_size);
+void rewind_release(struct rewind *rw);
+void rewind_push(struct rewind *rw, struct gb_emulator *gb);
+u32 rewind_step(struct rewind *rw, struct gb_emulator *gb, u32 frames);
+size_t rewind_delta_encode(const u8 *a, const u8 *b, size_t size,
+			   u8 *out);
+void rewind_delta_apply(u8 *state, const u8 *delta, size_t size);
+size_t rewind_delta_bound(size_t size);
+
+// Record the frame that just ended, only between whole steps so the
+// state can be resumed
+static inline void rewind_update(struct gb_emulator *gb)
+{
+	if (gb->rewind && gb->rewind->pending)
+		rewind_push(gb->rewind, gb);
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef _SCHEDULER_H
+#define _SCHEDULER_H
+
+#include "platform/types.h"
+
+#define SCHEDULER_NEVER UINT64_MAX
+
+enum scheduler_event {
+	EVENT_PPU,
+	EVENT_TIMER,
+	EVENT_INPUT,
+	EVENT_COUNT,
+};
+
+struct scheduler_entry {
+	u64 deadline;
+	enum scheduler_event event;
+};
+
+// Binary min-heap keyed on the absolute cycle of each deadline, an event
+// is queued at most once
+struct scheduler {
+	struct scheduler_entry heap[EVENT_COUNT];
+	int position[EVENT_COUNT];
+	int size;
+};
+
+void scheduler_init(struct scheduler *sched);
+void scheduler_schedule(struct scheduler *sched, enum scheduler_event event,
+			u64 deadline);
+void scheduler_cancel(struct scheduler *sched, enum scheduler_event event);
+enum scheduler_event scheduler_pop(struct scheduler *sched);
+
+static inline u64 scheduler_next(struct scheduler *sched)
+{
+	if (!sched->size)
+		return SCHEDULER_NEVER;
+	return sched->heap[0].deadline;
+}
+
+#endif
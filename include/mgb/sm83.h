@@ -2,29 +2,39 @@
 #define _SM83_H
 
 #include "platform/types.h"
+#include "mgb/memory.h"
+#include "mgb/profile.h"
 
 struct sm83_core;
 
 enum {
 	SM83_FREQ = 4194304,
-	SM83_DMA_TRANSFER_CYCLES = 160
+	SM83_DMA_TRANSFER_CYCLES = 160,
+	SM83_IDLE_LOOP_SIZE = 16, // Bytes, branch excluded
 };
 
 struct sm83_memory {
 	u8 (*load8)(struct sm83_core *, u16 addr);
 	void (*write8)(struct sm83_core *, u16 addr, u8 value);
+	// Run device events due by the current cycle
+	void (*sync)(struct sm83_core *);
+	// Directly addressable pages, NULL pages fall back to load8/write8
+	u8 *load_pages[MEMORY_PAGE_COUNT];
+	u8 *write_pages[MEMORY_PAGE_COUNT];
+	// Raw hardware registers page (0xFF00-0xFFFF) for internal devices
+	u8 *io;
 };
 
 struct sm83_instruction {
 	u8 opcode;
-	const char *mnemonic;
-	const char *op1;
-	const char *op2;
-	u16 length;
-	u16 cycles;
+	u8 length;
+	u8 cycles;
 	bool prefixed;
 };
 
+// Non-prefixed opcodes first, followed by the CB prefixed ones
+extern const struct sm83_instruction sm83_instructions[512];
+
 enum sm83_state {
 	SM83_CORE_FETCH,
 	SM83_CORE_PC,
@@ -61,43 +71,150 @@ struct dma_transfer {
 	u16 remaining;
 };
 
-struct sm83_core {
+// DIV and TIMA are derived from the cycle counter, see timer.c
+struct sm83_timer {
+	u64 div_epoch; // Cycle at which DIV was reset
+	u64 tima_epoch; // Cycle at which TIMA held tima
+	u64 phase; // Cycles counted toward the next TIMA increment when stopped
+	u64 period; // TIMA increment period, 0 when stopped
+	u64 overflow; // Cycle of the next TIMA overflow
+	u8 tima;
+};
+
+// Registers at the head of the last polling loop reached, see
+// sm83_idle_loop
+struct sm83_idle {
+	bool valid;
+	u16 pc;
 	u8 a;
 	u8 f;
-	u8 b;
-	u8 c;
-	u8 d;
-	u8 e;
-	u8 h;
-	u8 l;
+	u64 cycles;
+	u64 instructions;
+};
+
+// Declared in every build so sm83_core keeps the same layout with or
+// without SM83_LAZY_FLAGS, the eager build leaves it unused
+enum sm83_lazy_op {
+	LAZY_NONE, // F is up to date
+	LAZY_ADD,
+	LAZY_SUB,
+	LAZY_AND,
+	LAZY_OR,
+	LAZY_INC,
+	LAZY_DEC,
+};
+
+// Last ALU operation, F is only computed from it when read, see sm83_flags
+struct sm83_lazy {
+	u8 op;
+	u8 x;
+	u8 y;
+	u8 carry; // FLAG_C kept by INC and DEC
+	u16 result; // Not truncated, bit 8 is the carry
+};
+
+// 16-bit register pair hilo with its two 8-bit halves hi and lo
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define SM83_PAIR(hi, lo)                                                     \
+	union {                                                               \
+		u16 hi##lo;                                                   \
+		struct {                                                      \
+			u8 hi;                                                \
+			u8 lo;                                                \
+		};                                                            \
+	}
+#else
+#define SM83_PAIR(hi, lo)                                                     \
+	union {                                                               \
+		u16 hi##lo;                                                   \
+		struct {                                                      \
+			u8 lo;                                                \
+			u8 hi;                                                \
+		};                                                            \
+	}
+#endif
+
+struct sm83_core {
+	SM83_PAIR(a, f);
+	SM83_PAIR(b, c);
+	SM83_PAIR(d, e);
+	SM83_PAIR(h, l);
 	u16 pc;
 	u16 sp;
 
 	u64 cycles;
+	u64 instructions;
 	u64 ime_cycles;
-	u64 internal_divider;
-	u64 internal_timer;
+	struct sm83_timer timer;
 
 	u8 bus;
 	u16 index;
 	u16 ptr;
 	u16 acc;
 	struct sm83_memory memory;
-	struct sm83_instruction instruction;
+	const struct sm83_instruction *instruction;
 	struct dma_transfer dma;
+	struct sm83_idle idle;
+	struct sm83_lazy lazy;
 
+	u8 pending; // IE & IF, see sm83_irq_refresh
 	bool ime;
 	bool halted;
-	bool timer_enabled;
 	bool dma_enabled;
 	enum sm83_state state;
 	enum sm83_state previous;
 
 	void *parent;
+	struct profile *profile;
 
 	u8 multiplier;
 };
 
+static inline u8 sm83_load8(struct sm83_core *cpu, u16 addr)
+{
+	u8 *page = cpu->memory.load_pages[addr >> MEMORY_PAGE_SHIFT];
+	PROFILE_LOAD(cpu->profile, addr);
+	if (page)
+		return page[addr & (MEMORY_PAGE_SIZE - 1)];
+	return cpu->memory.load8(cpu, addr);
+}
+
+static inline void sm83_write8(struct sm83_core *cpu, u16 addr, u8 value)
+{
+	u8 *page = cpu->memory.write_pages[addr >> MEMORY_PAGE_SHIFT];
+	PROFILE_WRITE(cpu->profile, addr);
+	if (page)
+		page[addr & (MEMORY_PAGE_SIZE - 1)] = value;
+	else
+		cpu->memory.write8(cpu, addr, value);
+}
+
+// Hardware register as seen by the devices, bypassing the bus handlers
+static inline u8 *sm83_io(struct sm83_core *cpu, u16 reg)
+{
+	return &cpu->memory.io[reg & (MEMORY_PAGE_SIZE - 1)];
+}
+
+// Every write to IE or IF, from the core or a device, refreshes the
+// cached pending interrupts
+static inline void sm83_irq_refresh(struct sm83_core *cpu)
+{
+	cpu->pending = *sm83_io(cpu, IE) & *sm83_io(cpu, IF) & 0x1F;
+}
+
+static inline void sm83_irq_request(struct sm83_core *cpu,
+				    enum sm83_irq number)
+{
+	*sm83_io(cpu, IF) |= 1 << number;
+	sm83_irq_refresh(cpu);
+}
+
+// Halted with no interrupt pending, only a device can wake the core up
+static inline bool sm83_halt_idle(struct sm83_core *cpu)
+{
+	return cpu->state == SM83_CORE_HALT && !cpu->pending;
+}
+
 static inline u8 msb(u16 value)
 {
 	return value >> 8;
@@ -105,7 +222,7 @@ static inline u8 msb(u16 value)
 
 static inline u8 lsb(u16 value)
 {
-	return value ^ 0xFF00;
+	return value & 0xFF;
 }
 
 static inline u16 unsigned_16(u8 lsb, u8 msb)
@@ -113,35 +230,78 @@ static inline u16 unsigned_16(u8 lsb, u8 msb)
 	return (u16)msb << 8 | lsb;
 }
 
-static inline void op_r16_set(u8 *r1, u8 *r2, u16 word)
+static inline const struct sm83_instruction *sm83_decode(u8 opcode,
+							 bool prefixed)
+{
+	return &sm83_instructions[(prefixed << 8) | opcode];
+}
+
+#ifdef SM83_LAZY_FLAGS
+static inline void sm83_lazy(struct sm83_core *cpu, enum sm83_lazy_op op,
+			     u8 x, u8 y, u16 result)
+{
+	cpu->lazy.op = op;
+	cpu->lazy.x = x;
+	cpu->lazy.y = y;
+	cpu->lazy.result = result;
+}
+
+static inline bool sm83_lazy_carry(const struct sm83_lazy *lazy)
 {
-	*r1 = msb(word);
-	*r2 = lsb(word);
+	if (lazy->op == LAZY_INC || lazy->op == LAZY_DEC)
+		return lazy->carry;
+	return lazy->result & 0x100;
 }
 
-#define AF(cpu) unsigned_16(cpu->f, cpu->a)
-#define BC(cpu) unsigned_16(cpu->c, cpu->b)
-#define DE(cpu) unsigned_16(cpu->e, cpu->d)
-#define HL(cpu) unsigned_16(cpu->l, cpu->h)
+static inline u8 sm83_lazy_flags(const struct sm83_lazy *lazy)
+{
+	u8 z = (u8)lazy->result ? FLAG_NONE : FLAG_Z;
+	u8 h = (lazy->x ^ lazy->y ^ lazy->result) & 0x10 ? FLAG_H : FLAG_NONE;
+	u8 c = sm83_lazy_carry(lazy) ? FLAG_C : FLAG_NONE;
+
+	switch (lazy->op) {
+	case LAZY_ADD:
+	case LAZY_INC:
+		return z | h | c;
+	case LAZY_SUB:
+	case LAZY_DEC:
+		return z | FLAG_N | h | c;
+	case LAZY_AND:
+		return z | FLAG_H;
+	default:
+		return z;
+	}
+}
+#endif
 
-#define SET_AF(cpu, value) op_r16_set(&cpu->a, &cpu->f, value)
-#define SET_BC(cpu, value) op_r16_set(&cpu->b, &cpu->c, value)
-#define SET_DE(cpu, value) op_r16_set(&cpu->d, &cpu->e, value)
-#define SET_HL(cpu, value) op_r16_set(&cpu->h, &cpu->l, value)
+// Materialized F, every reader outside of the ALU helpers goes through this
+static inline u8 sm83_flags(struct sm83_core *cpu)
+{
+#ifdef SM83_LAZY_FLAGS
+	if (cpu->lazy.op != LAZY_NONE) {
+		cpu->f = sm83_lazy_flags(&cpu->lazy);
+		cpu->lazy.op = LAZY_NONE;
+	}
+#endif
+	return cpu->f;
+}
 
 static inline void cpu_flag_set(struct sm83_core *cpu, int flag)
 {
+#ifdef SM83_LAZY_FLAGS
+	cpu->lazy.op = LAZY_NONE;
+#endif
 	cpu->f = flag;
 }
 
 static inline void cpu_flag_toggle(struct sm83_core *cpu, int flag)
 {
-	cpu->f |= flag;
+	cpu->f = sm83_flags(cpu) | flag;
 }
 
 static inline void cpu_flag_untoggle(struct sm83_core *cpu, int flag)
 {
-	cpu->f &= (~flag);
+	cpu->f = sm83_flags(cpu) & ~flag;
 }
 
 static inline void cpu_flag_clear(struct sm83_core *cpu)
@@ -151,12 +311,19 @@ static inline void cpu_flag_clear(struct sm83_core *cpu)
 
 static inline bool cpu_flag_is_set(struct sm83_core *cpu, int flag)
 {
-	return (cpu->f & flag) != 0;
+#ifdef SM83_LAZY_FLAGS
+	// Conditional branches only test Z or C, no need for the whole F
+	if (cpu->lazy.op != LAZY_NONE && flag == FLAG_Z)
+		return !(u8)cpu->lazy.result;
+	if (cpu->lazy.op != LAZY_NONE && flag == FLAG_C)
+		return sm83_lazy_carry(&cpu->lazy);
+#endif
+	return (sm83_flags(cpu) & flag) != 0;
 }
 
 static inline void cpu_flag_flip(struct sm83_core *cpu, int flag)
 {
-	cpu->f ^= flag;
+	cpu->f = sm83_flags(cpu) ^ flag;
 }
 
 static inline void cpu_flag_set_or_clear(struct sm83_core *cpu, int flag)
@@ -169,18 +336,20 @@ static inline void cpu_flag_set_or_clear(struct sm83_core *cpu, int flag)
 
 /* sm83.c */
 void sm83_cpu_step(struct sm83_core *cpu);
+u32 sm83_cpu_run_instruction(struct sm83_core *cpu);
 void sm83_cpu_execute(struct sm83_core *cpu);
 void sm83_cpu_reset(struct sm83_core *cpu);
 void sm83_cpu_plug_memory(struct sm83_core *cpu, struct sm83_memory *bus);
 void sm83_destroy(struct sm83_core *cpu);
 void sm83_halt(struct sm83_core *cpu);
+u32 sm83_idle_loop(struct sm83_core *cpu);
 void sm83_schedule_dma_transfer(struct sm83_core *cpu, u16 start_addr);
 
 /* sm83_isa.c */
 void sm83_isa_execute(struct sm83_core *cpu);
 
 /* decoder.c */
-struct sm83_instruction sm83_decode(struct sm83_core *cpu);
+const char *sm83_mnemonic(const struct sm83_instruction *instruction);
 void sm83_disassemble(struct sm83_core *cpu, char *buffer);
 void sm83_info(struct sm83_core *cpu);
 
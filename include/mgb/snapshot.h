@@ -0,0 +1,49 @@
+#ifndef _SNAPSHOT_H
+#define _SNAPSHOT_H
+
+#include "platform/types.h"
+#include "mgb/memory.h"
+#include "mgb/video.h"
+
+// Tracked pages are the pages of memory.ram followed by the cartridge RAM
+#define DIRTY_CARTRIDGE_PAGES (0x20000 >> MEMORY_PAGE_SHIFT)
+#define DIRTY_PAGES (MEMORY_PAGE_COUNT + DIRTY_CARTRIDGE_PAGES)
+#define DIRTY_WORDS (DIRTY_PAGES / 64)
+#define DIRTY_LINE_WORDS ((GB_HEIGHT + 63) / 64)
+// Longest parent chain, the next snapshot is taken whole
+#define SNAPSHOT_MAX_DEPTH 32
+
+struct gb_emulator;
+struct gb_state_core;
+
+// Pages written since the last snapshot. Clean writable pages are taken
+// out of the CPU write table, the first write to one of them falls back
+// to gb_cpu_write which marks it and puts it back, so tracking costs
+// nothing once a page is dirty.
+struct dirty_map {
+	bool enabled;
+	u64 bits[DIRTY_WORDS];
+	u8 *pages[MEMORY_PAGE_COUNT]; // Write pages withheld from the CPU
+};
+
+// Machine state along with the pages and frame buffer lines written since
+// its parent, stored in bitmap order. A snapshot without a parent holds
+// every page, chains are bounded by SNAPSHOT_MAX_DEPTH.
+struct gb_snapshot {
+	struct gb_snapshot *parent;
+	u32 refs;
+	u32 depth;
+	struct gb_state_core *core;
+	u64 pages[DIRTY_WORDS];
+	u64 lines[DIRTY_LINE_WORDS];
+	u8 *data;
+};
+
+struct gb_snapshot *gb_snapshot_take(struct gb_emulator *gb);
+int gb_snapshot_restore(struct gb_emulator *gb, struct gb_snapshot *snapshot);
+void gb_snapshot_release(struct gb_snapshot *snapshot);
+bool gb_dirty_fault(struct gb_emulator *gb, u16 addr, u8 value);
+void gb_dirty_remap(struct gb_emulator *gb);
+void gb_dirty_reset(struct gb_emulator *gb);
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef _STATE_H
+#define _STATE_H
+
+#include "platform/types.h"
+#include "mgb/emulator.h"
+#include <stddef.h>
+
+#define MGB_STATE_MAGIC 0x5342474D // "MGBS"
+#define MGB_STATE_VERSION 3
+
+// Only the parts of the address space backed by memory.ram, the ROM and
+// the cartridge RAM are owned by the cartridge
+#define MGB_STATE_VRAM_START 0x8000
+#define MGB_STATE_VRAM_SIZE 0x2000
+// WRAM, echo RAM, OAM, hardware registers and HRAM
+#define MGB_STATE_RAM_START 0xC000
+#define MGB_STATE_RAM_SIZE 0x4000
+
+struct gb_state_header {
+	u32 magic;
+	u16 version;
+	u16 type; // Cartridge type, a state only loads on the same hardware
+	u32 size; // Whole state, cartridge RAM included
+	u32 ram_size;
+};
+
+// Core registers and micro-op state, the instruction is stored as its
+// index in sm83_instructions
+struct gb_state_cpu {
+	u64 cycles;
+	u64 instructions;
+	u64 ime_cycles;
+	struct sm83_timer timer;
+	struct dma_transfer dma;
+	u16 pc;
+	u16 sp;
+	u16 index;
+	u16 ptr;
+	u16 acc;
+	u16 instruction;
+	u8 a;
+	u8 f;
+	u8 b;
+	u8 c;
+	u8 d;
+	u8 e;
+	u8 h;
+	u8 l;
+	u8 bus;
+	u8 ime;
+	u8 halted;
+	u8 dma_enabled;
+	u8 state;
+	u8 previous;
+	u8 multiplier;
+};
+
+struct gb_state_ppu {
+	u64 frames;
+	u64 dots;
+	u64 cycles;
+	u32 x;
+	u8 ly;
+	u8 mode;
+	u8 window_line;
+};
+
+// Everything but the memory, shared with incremental snapshots
+struct gb_state_core {
+	struct gb_state_cpu cpu;
+	struct gb_state_ppu gpu;
+	struct scheduler scheduler;
+	struct cartridge_registers cartridge;
+	u8 keys;
+};
+
+// Fixed part of a save state, followed by ram_size bytes of cartridge RAM
+struct gb_state {
+	struct gb_state_header header;
+	struct gb_state_core core;
+	u8 frame_buffer[GB_HEIGHT * GB_WIDTH];
+	u8 vram[MGB_STATE_VRAM_SIZE];
+	u8 ram[MGB_STATE_RAM_SIZE];
+};
+
+/* state.c */
+void gb_state_save_core(struct gb_emulator *gb, struct gb_state_core *core);
+void gb_state_load_core(struct gb_emulator *gb,
+			const struct gb_state_core *core);
+size_t mgb_state_size(struct gb_emulator *gb);
+size_t mgb_save_state(struct gb_emulator *gb, void *buffer, size_t size);
+int mgb_load_state(struct gb_emulator *gb, const void *buffer, size_t size);
+int gb_save_state_file(struct gb_emulator *gb, const char *path);
+int gb_load_state_file(struct gb_emulator *gb, const char *path);
+
+#endif
@@ -4,18 +4,25 @@
 #include "platform/types.h"
 #include "mgb/sm83.h"
 
+#define SM83_TIMER_STOPPED UINT64_MAX
+
 enum div_register_freq {
 	DIV_PERIOD = 16384,
 	DIV_PERIOD_DOUBLE_SPEED = 32768,
 };
 
-static const u64 tima_periods[] = {
-	256,
-	4,
-	16,
-	64,
-};
+void sm83_timer_reset(struct sm83_core *cpu);
+u8 sm83_timer_load(struct sm83_core *cpu, u16 reg);
+void sm83_timer_write(struct sm83_core *cpu, u16 reg, u8 value);
+void sm83_timer_flush(struct sm83_core *cpu);
+void sm83_timer_overflow(struct sm83_core *cpu);
 
-void sm83_update_timer_registers(struct sm83_core *cpu);
+// DIV and TIMA are computed from the cycle counter on access, the timer
+// only has work to do when TIMA overflows
+static inline void sm83_timer_update(struct sm83_core *cpu)
+{
+	if (cpu->cycles >= cpu->timer.overflow)
+		sm83_timer_overflow(cpu);
+}
 
 #endif
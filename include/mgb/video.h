@@ -1,3 +1,6 @@
+#ifndef _VIDEO_H
+#define _VIDEO_H
+
 #include "mgb/sm83.h"
 #include "platform/types.h"
 
@@ -8,11 +11,18 @@ enum {
 	GB_VIDEO_VERTICAL_TOTAL_PIXELS = 154,
 	GB_VIDEO_FRAME_PERIOD = 70224,
 	GB_VIDEO_SCANLINE_PERIOD = 456,
+	GB_VIDEO_OAM_SCAN_PERIOD = 80,
+	GB_VIDEO_DRAWING_PERIOD = 172,
+	GB_OBJECTS = 40,
+	GB_OBJECTS_PER_LINE = 10,
 	GB_BG_MAP_WIDTH = 256,
 	GB_BG_MAP_HEIGHT = 256,
 	GB_TILE_SIZE = 8,
 	GB_TILE_MEMORY_SIZE = 16,
-	GB_TILEMAP_SIZE = 32
+	GB_TILEMAP_SIZE = 32,
+	GB_TILEDATA_WIDTH = 128,
+	GB_TILEDATA_HEIGHT = 192,
+	GB_VRAM_SIZE = 0x2000,
 };
 
 enum ppu_mode {
@@ -60,17 +70,10 @@ enum oam_flag_attribute {
 };
 
 #define FLAG_ENABLE(byte, flag) (byte & (1 << flag)) != 0
-#define FLAG_MEM_ENABLE(addr, flag) FLAG_ENABLE(gpu->ram.load(gpu, addr), flag)
+#define FLAG_MEM_ENABLE(addr, flag) FLAG_ENABLE(ppu_load(gpu, addr), flag)
 #define LCD_CONTROL(flag) FLAG_MEM_ENABLE(LCDC_LCD, flag)
 #define LCD_STATUS(flag) FLAG_MEM_ENABLE(STAT_LCD, flag)
 
-static const int DMG_PALETTE[4] = {
-	DMG_WHITE,
-	DMG_LIGHTGRAY,
-	DMG_DARKGRAY,
-	DMG_BLACK,
-};
-
 enum vram_area {
 	VRAM_AREA_WINDOW_TILEMAP,
 	VRAM_AREA_BG_WINDOW_TILE,
@@ -82,35 +85,15 @@ struct vram_area_range {
 	u16 end;
 };
 
-// clang-format off
-static const struct vram_area_range vram_areas[][2] = {
-	{
-		{ 0x9800, 0x9BFF },
-		{ 0x9C00, 0x9FFF },
-	},
-	{
-		{ 0x8800, 0x97FF },
-		{ 0x8000, 0x8FFF },
-	},
-	{
-		{ 0x9800, 0x9BFF },
-		{ 0x9C00, 0x9FFF },
-	},
-};
-// clang-format on
-
 struct ppu;
 struct ppu_memory;
 
-struct render {
-	// int (*create_window)(struct ppu *gpu, int width, int height, int scale);
-	void (*draw)(struct ppu *gpu, int x, int y, int color);
-};
-
 struct ppu_memory {
 	u8 (*load)(struct ppu *gpu, u16 addr);
 	void (*write)(struct ppu *gpu, u16 addr, u8 value);
 	u8 *(*offset)(struct ppu *gpu, u16 offset);
+	// Directly addressable pages, NULL pages fall back to load/write
+	u8 *pages[MEMORY_PAGE_COUNT];
 };
 
 struct ppu {
@@ -128,14 +111,47 @@ struct ppu {
 	u8 scale;
 	u64 frames;
 	u64 dots;
-	struct render renderer;
+	u8 window_line;
+	u64 cycles; // CPU cycle the PPU caught up to
+	// Frame buffer lines rendered since the last snapshot
+	u64 dirty_lines[(GB_HEIGHT + 63) / 64];
 	struct ppu_memory ram;
+	// Called once the frame buffer holds a finished frame
+	void (*vblank)(struct ppu *gpu);
+	// IF is only written through this, the core caches it
+	void (*interrupt)(struct ppu *gpu, enum sm83_irq number);
 	void *parent;
+	struct profile *profile;
 };
 
+static inline u8 ppu_load(struct ppu *gpu, u16 addr)
+{
+	u8 *page = gpu->ram.pages[addr >> MEMORY_PAGE_SHIFT];
+	if (page)
+		return page[addr & (MEMORY_PAGE_SIZE - 1)];
+	return gpu->ram.load(gpu, addr);
+}
+
+static inline void ppu_write(struct ppu *gpu, u16 addr, u8 value)
+{
+	u8 *page = gpu->ram.pages[addr >> MEMORY_PAGE_SHIFT];
+	if (page)
+		page[addr & (MEMORY_PAGE_SIZE - 1)] = value;
+	else
+		gpu->ram.write(gpu, addr, value);
+}
+
 void ppu_init(struct ppu *gpu);
 void ppu_reset(struct ppu *gpu);
 void draw_scanline(struct ppu *gpu);
-void ppu_draw(struct ppu *gpu);
-void ppu_tick(struct ppu *gpu, struct sm83_core *cpu);
+void ppu_blit_frame(const u8 *frame_buffer, u32 *pixels);
+void ppu_blit_tiledata(const u8 *vram, u32 *pixels);
+void ppu_blit_tilemap(const u8 *vram, u8 lcdc, enum vram_area area,
+		      u32 *pixels);
+void ppu_run(struct ppu *gpu, struct sm83_core *cpu, u32 cycles);
+void ppu_write_control(struct ppu *gpu, u8 value);
+void ppu_sync(struct ppu *gpu, struct sm83_core *cpu, u64 now);
+u64 ppu_next_event(struct ppu *gpu, struct sm83_core *cpu);
 void ppu_info(struct ppu *gpu);
+
+#endif
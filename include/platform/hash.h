@@ -0,0 +1,20 @@
+#ifndef _HASH_H
+#define _HASH_H
+
+#include "platform/types.h"
+#include <stddef.h>
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+// 64-bit FNV-1a, chain calls by passing the previous hash
+static inline u64 hash_fnv1a(u64 hash, const u8 *data, size_t size)
+{
+	for (size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+#endif
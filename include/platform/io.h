@@ -2,10 +2,9 @@
 #define _IO_H
 
 #include "platform/types.h"
-#include <stdio.h>
+#include <stddef.h>
 
-size_t fs_size(FILE *file);
-u8 *fs_read(FILE *file, size_t size_in_bytes);
-u8 *readfile(char *path);
+u8 *fs_map(const char *path, size_t *size);
+void fs_unmap(u8 *data, size_t size);
 
 #endif
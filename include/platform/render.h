@@ -12,23 +12,15 @@ struct keybind {
 	const char *label;
 };
 
-// clang-format off
-static const struct keybind keybindings[] = {
-	{ KEY_Q, BUTTON_A, "A", },
-	{ KEY_W, BUTTON_B, "B", },
-	{ KEY_R, BUTTON_SELECT, "SELECT", },
-	{ KEY_E, BUTTON_START, "START" },
-	{ KEY_RIGHT, BUTTON_RIGHT, "RIGHT" },
-	{ KEY_LEFT, BUTTON_LEFT, "LEFT" },
-	{ KEY_UP, BUTTON_UP, "UP" },
-	{ KEY_DOWN, BUTTON_DOWN, "DOWN" },
-};
-// clang-format on
-
-void render_pixel(int x, int y, int color, int scale);
+// RGBA8888 textures, drawn as a single scaled quad
+Texture2D render_texture_create(int width, int height);
+void render_texture_update(Texture2D texture, const u32 *pixels);
+void render_texture_draw(Texture2D texture, int x, int y, int scale);
+void render_texture_release(Texture2D texture);
 void render_init(int width, int height, int scale);
 bool render_is_running(void);
 void render_handle_inputs(u8 *keys);
+bool render_rewind_requested(void);
 void render_debug(char *label, int value, int x, int y, int height);
 void render_begin(void);
 void render_end(void);
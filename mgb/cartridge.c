@@ -0,0 +1,284 @@
+#include "platform/io.h"
+#include "platform/mm.h"
+#include "mgb/cartridge.h"
+#include "mgb/memory.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const u32 CARTRIDGE_RAM_SIZES[6] = {
+	0, // No RAM
+	0, // Unused
+	8192, // 1 Bank
+	32768, // 4 Banks of 8KiB each
+	131072, // 16 Banks of 8KiB each
+	65536 // 8 Banks of 8KiB each
+};
+
+static int cartridge_controller(enum cartridge_type type,
+				enum cartridge_controller *controller)
+{
+	switch (type) {
+	case ROM_ONLY:
+	case ROM_RAM_9:
+	case ROM_RAM_BATTERY_9:
+		*controller = CONTROLLER_NONE;
+		return 0;
+	case MBC1:
+	case MBC1_RAM:
+	case MBC1_RAM_BATTERY:
+		*controller = CONTROLLER_MBC1;
+		return 0;
+	case MBC3_TIMER_BATTERY:
+	case MBC3_TIMER_RAM_BATTERY_10:
+	case MBC3:
+	case MBC3_RAM_10:
+	case MBC3_RAM_BATTERY_10:
+		*controller = CONTROLLER_MBC3;
+		return 0;
+	case MBC5:
+	case MBC5_RAM:
+	case MBC5_RAM_BATTERY:
+	case MBC5_RUMBLE:
+	case MBC5_RUMBLE_RAM:
+	case MBC5_RUMBLE_RAM_BATTERY:
+		*controller = CONTROLLER_MBC5;
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+// Bank masks need a power of two, smaller images are padded with 0xFF
+static u16 cartridge_rom_banks(size_t size)
+{
+	u16 banks = 2;
+	while ((size_t)banks * CARTRIDGE_ROM_BANK_SIZE < size)
+		banks <<= 1;
+	return banks;
+}
+
+// Images with a power of two number of banks are used in place from the
+// read-only mapping, others are copied once into a padded buffer
+static int cartridge_image(struct cartridge *cart, u8 *image, size_t size)
+{
+	cart->rom_banks = cartridge_rom_banks(size);
+	cart->rom_size = (size_t)cart->rom_banks * CARTRIDGE_ROM_BANK_SIZE;
+	if (cart->rom_size == size) {
+		cart->rom = image;
+		cart->mapped = true;
+		return 0;
+	}
+	cart->rom = malloc(cart->rom_size);
+	if (cart->rom) {
+		memcpy(cart->rom, image, size);
+		memset(cart->rom + size, 0xFF, cart->rom_size - size);
+	}
+	fs_unmap(image, size);
+	return cart->rom ? 0 : -1;
+}
+
+int cartridge_load(struct cartridge *cart, const char *path)
+{
+	u8 *image;
+	size_t size;
+	u8 ram_size;
+
+	memset(cart, 0, sizeof(struct cartridge));
+	if (!(image = fs_map(path, &size)))
+		return -1;
+	if (cartridge_image(cart, image, size))
+		return -1;
+	cart->type = cart->rom[CARTRIDGE_TYPE];
+	if (cartridge_controller(cart->type, &cart->controller))
+		goto err;
+	ram_size = cart->rom[CARTRIDGE_RAM_SIZE];
+	if (ram_size < ARRAY_SIZE(CARTRIDGE_RAM_SIZES))
+		cart->ram_size = CARTRIDGE_RAM_SIZES[ram_size];
+	cart->ram_banks = cart->ram_size / CARTRIDGE_RAM_BANK_SIZE;
+	if (cart->ram_size && !(cart->ram = calloc(cart->ram_size, 1)))
+		goto err;
+	cartridge_reset(cart);
+	return 0;
+err:
+	cartridge_release(cart);
+	return -1;
+}
+
+void cartridge_release(struct cartridge *cart)
+{
+	if (cart->mapped)
+		fs_unmap(cart->rom, cart->rom_size);
+	else
+		zfree(cart->rom);
+	zfree(cart->ram);
+	cart->rom = NULL;
+	cart->ram = NULL;
+	cart->mapped = false;
+}
+
+void cartridge_reset(struct cartridge *cart)
+{
+	memset(&cart->regs, 0, sizeof(struct cartridge_registers));
+	cart->regs.rom_bank = 1;
+	cart->rom0 = NULL;
+	cart->romx = NULL;
+	cart->sram = NULL;
+}
+
+static u8 *cartridge_rom_bank(struct cartridge *cart, u16 bank)
+{
+	return cart->rom +
+	       (size_t)(bank & (cart->rom_banks - 1)) * CARTRIDGE_ROM_BANK_SIZE;
+}
+
+static u8 *cartridge_ram_bank(struct cartridge *cart, u8 bank)
+{
+	if (!cart->ram_banks || !cart->regs.ram_enabled)
+		return NULL;
+	return cart->ram +
+	       (size_t)(bank & (cart->ram_banks - 1)) * CARTRIDGE_RAM_BANK_SIZE;
+}
+
+static void map_pages(struct sm83_memory *memory, u16 start, u16 size,
+		      u8 *bank, bool writable)
+{
+	for (int i = 0; i < size >> MEMORY_PAGE_SHIFT; i++) {
+		u8 *page = bank ? bank + (i << MEMORY_PAGE_SHIFT) : NULL;
+		memory->load_pages[(start >> MEMORY_PAGE_SHIFT) + i] = page;
+		memory->write_pages[(start >> MEMORY_PAGE_SHIFT) + i] =
+			writable ? page : NULL;
+	}
+}
+
+// Banks are switched by pointing the page table at another part of the
+// image, only the regions whose bank changed are remapped
+void cartridge_map(struct cartridge *cart, struct sm83_memory *memory,
+		   bool force)
+{
+	struct cartridge_registers *regs = &cart->regs;
+	u8 *rom0 = cart->rom;
+	u8 *romx;
+	u8 *sram;
+	u8 upper;
+
+	switch (cart->controller) {
+	case CONTROLLER_MBC1:
+		upper = regs->ram_bank & 0x3;
+		if (regs->mode)
+			rom0 = cartridge_rom_bank(cart, upper << 5);
+		romx = cartridge_rom_bank(cart, upper << 5 | regs->rom_bank);
+		sram = cartridge_ram_bank(cart, regs->mode ? upper : 0);
+		break;
+	case CONTROLLER_MBC3:
+		romx = cartridge_rom_bank(cart, regs->rom_bank);
+		// RTC registers go through cartridge_load_ram
+		sram = regs->ram_bank < 4 ?
+			       cartridge_ram_bank(cart, regs->ram_bank) :
+			       NULL;
+		break;
+	case CONTROLLER_MBC5:
+		romx = cartridge_rom_bank(cart, regs->rom_bank);
+		sram = cartridge_ram_bank(cart, regs->ram_bank);
+		break;
+	default:
+		romx = cartridge_rom_bank(cart, 1);
+		sram = cart->ram;
+		break;
+	}
+	if (force || rom0 != cart->rom0)
+		map_pages(memory, 0x0000, CARTRIDGE_ROM_BANK_SIZE, rom0, false);
+	if (force || romx != cart->romx)
+		map_pages(memory, CARTRIDGE_ROM_BANK_SIZE,
+			  CARTRIDGE_ROM_BANK_SIZE, romx, false);
+	if (force || sram != cart->sram)
+		map_pages(memory, CARTRIDGE_RAM_START, CARTRIDGE_RAM_BANK_SIZE,
+			  sram, true);
+	cart->rom0 = rom0;
+	cart->romx = romx;
+	cart->sram = sram;
+}
+
+// Writes to 0x0000-0x7FFF, the caller remaps the banks afterwards
+void cartridge_write(struct cartridge *cart, u16 addr, u8 value)
+{
+	struct cartridge_registers *regs = &cart->regs;
+
+	switch (cart->controller) {
+	case CONTROLLER_MBC1:
+		switch (addr >> 13) {
+		case 0:
+			regs->ram_enabled = (value & 0xF) == 0xA;
+			break;
+		case 1:
+			regs->rom_bank = value & 0x1F ? value & 0x1F : 1;
+			break;
+		case 2:
+			regs->ram_bank = value & 0x3;
+			break;
+		case 3:
+			regs->mode = value & 0x1;
+			break;
+		}
+		break;
+	case CONTROLLER_MBC3:
+		switch (addr >> 13) {
+		case 0:
+			regs->ram_enabled = (value & 0xF) == 0xA;
+			break;
+		case 1:
+			regs->rom_bank = value & 0x7F ? value & 0x7F : 1;
+			break;
+		case 2:
+			regs->ram_bank = value & 0xF;
+			break;
+		}
+		break;
+	case CONTROLLER_MBC5:
+		switch (addr >> 12) {
+		case 0:
+		case 1:
+			regs->ram_enabled = (value & 0xF) == 0xA;
+			break;
+		case 2:
+			regs->rom_bank = (regs->rom_bank & 0x100) | value;
+			break;
+		case 3:
+			regs->rom_bank = (regs->rom_bank & 0xFF) |
+					 (value & 0x1) << 8;
+			break;
+		case 4:
+		case 5:
+			regs->ram_bank = value & 0xF;
+			break;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static u8 *cartridge_rtc(struct cartridge *cart)
+{
+	struct cartridge_registers *regs = &cart->regs;
+
+	if (cart->controller != CONTROLLER_MBC3 || !regs->ram_enabled ||
+	    regs->ram_bank < 0x8 ||
+	    regs->ram_bank >= 0x8 + CARTRIDGE_RTC_REGISTERS)
+		return NULL;
+	return &regs->rtc[regs->ram_bank - 0x8];
+}
+
+// 0xA000-0xBFFF accesses while no RAM bank is mapped: disabled RAM or
+// the MBC3 clock registers, which are kept but do not tick
+u8 cartridge_load_ram(struct cartridge *cart, u16 addr)
+{
+	u8 *rtc = cartridge_rtc(cart);
+	return rtc ? *rtc : 0xFF;
+}
+
+void cartridge_write_ram(struct cartridge *cart, u16 addr, u8 value)
+{
+	u8 *rtc = cartridge_rtc(cart);
+	if (rtc)
+		*rtc = value;
+}
@@ -1,10 +1,39 @@
 #include "mgb/debugger.h"
+#include "mgb/rewind.h"
+#include "mgb/state.h"
 #include "platform/mm.h"
 #include "platform/types.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 
+// clang-format off
+static const struct cmd_struct commands[] = {
+	[COMMAND_NEXT]       = { "next (n)                Next instruction\n", "next", "n" },
+	[COMMAND_STEP]       = { "step (s)                Step one M-cycle\n", "step", "s" },
+	[COMMAND_BREAKPOINT] = { "break (b) <addr>        Set a breakpoint\n", "break", "b" },
+	[COMMAND_DELETE]     = { "del (d)                 Delete breakpoint or wacher\n", "del", "d" },
+	[COMMAND_CONTINUE]   = { "continue (c)            Continue until next breakpoint\n", "continue", "c" },
+	[COMMAND_PRINT]      = { "print (p) <addr>        Print address value\n", "print", "p" },
+	[COMMAND_RANGE]      = { "range (r) <addr> <addr> Dump memory range\n", "range", "r" },
+	[COMMAND_MEM]        = { "mem (m)                 Dump memory\n", "mem", "m" },
+	[COMMAND_INFO]       = { "info (in)               Print information\n", "info", "i" },
+	[COMMAND_IO]         = { "io (io)                 Dump I/O ranges\n", "io", "io" },
+	[COMMAND_FRAME]      = { "frame (f)               Next frame\n", "frame", "f" },
+	[COMMAND_SET]        = { "set (s) <addr> <value>  Set value\n", "set", "s" },
+	[COMMAND_RESET]      = { "reset (r)               Reset\n", "reset", "r" },
+	[COMMAND_QUIT]       = { "quit (q)                Quit\n", "quit", "q" },
+	[COMMAND_HELP]       = { "help (h)                Display this message\n", "help", "h" },
+	[COMMAND_WATCH]      = { "watch (w) <addr>        Watch address\n", "watch", "w" },
+	[COMMAND_LIST]       = { "list (ll)               List breakpoints and watchers\n", "list", "ll" },
+	[COMMAND_SAVE]       = { "save (sv)               Save the current state\n", "save", "sv" },
+	[COMMAND_LOAD]       = { "load (ld)               Load the saved state\n", "load", "ld" },
+	[COMMAND_CLEAR]      = { "clear (cl)              Clear all watch and break points\n", "clear", "cl" },
+	[COMMAND_REWIND]     = { "rewind (rw) <frames>    Go back in time\n", "rewind", "rw" },
+	[COMMAND_PROFILE]    = { "profile (pf)            Print the profiler report\n", "profile", "pf" },
+};
+// clang-format on
+
 static void print_help()
 {
 	for (int i = 0; i < ARRAY_SIZE(commands); i++) {
@@ -52,7 +81,7 @@ static int get_option(char **buffer, char *option, char *delims)
 	return 0;
 }
 
-static int parse_hex(struct debugger *dbg, char **buffer)
+static int parse_number(struct debugger *dbg, char **buffer, int base)
 {
 	char option[COMMAND_MAX_LENGTH] = "";
 
@@ -60,7 +89,12 @@ static int parse_hex(struct debugger *dbg, char **buffer)
 		dbg->command.type = COMMAND_HELP;
 		return 0;
 	}
-	return strtol(option, NULL, 16);
+	return strtol(option, NULL, base);
+}
+
+static int parse_hex(struct debugger *dbg, char **buffer)
+{
+	return parse_number(dbg, buffer, 16);
 }
 
 static void move_to_wait(struct debugger *dbg)
@@ -176,7 +210,9 @@ static int command_parse(struct debugger *dbg, char *buffer)
 	case COMMAND_CONTINUE:
 	case COMMAND_LIST:
 	case COMMAND_SAVE:
+	case COMMAND_LOAD:
 	case COMMAND_CLEAR:
+	case COMMAND_PROFILE:
 		break;
 	case COMMAND_BREAKPOINT:
 	case COMMAND_DELETE:
@@ -192,6 +228,9 @@ static int command_parse(struct debugger *dbg, char *buffer)
 		dbg->command.addr = parse_hex(dbg, &buffer);
 		dbg->command.end = parse_hex(dbg, &buffer);
 		break;
+	case COMMAND_REWIND:
+		dbg->command.counter = parse_number(dbg, &buffer, 10);
+		break;
 	}
 	return 0;
 }
@@ -252,21 +291,26 @@ static int debugger_command_handle(struct debugger *dbg)
 		}
 		break;
 	case COMMAND_PRINT:
+		sm83_timer_flush(&dbg->gb->cpu);
 		print_addr(&dbg->gb->memory, dbg->command.addr);
 		break;
 	case COMMAND_RANGE:
 		break;
 	case COMMAND_MEM:
+		sm83_timer_flush(&dbg->gb->cpu);
 		dump_memory(&dbg->gb->memory);
 		break;
 	case COMMAND_IO:
+		sm83_timer_flush(&dbg->gb->cpu);
 		print_hardware_registers(&dbg->gb->memory);
 		break;
 	case COMMAND_SET:
-		dbg->gb->memory.ram[dbg->command.addr] = dbg->command.value;
+		// Through the bus so devices and dirty tracking see the write
+		dbg->gb->cpu.memory.write8(&dbg->gb->cpu, dbg->command.addr,
+					   dbg->command.value);
 		break;
 	case COMMAND_RESET:
-		sm83_cpu_reset(&dbg->gb->cpu);
+		gb_reset(dbg->gb);
 		break;
 	case COMMAND_INFO:
 		sm83_info(&dbg->gb->cpu);
@@ -307,12 +351,30 @@ static int debugger_command_handle(struct debugger *dbg)
 		}
 		break;
 	case COMMAND_SAVE:
-		printf("Dumping memory to dump.sav\n");
-		dump_memory_to_file(&dbg->gb->memory, "dump.sav");
+		printf("Saving state to dump.sav\n");
+		if (gb_save_state_file(dbg->gb, "dump.sav"))
+			printf("Failed to write save\n");
+		break;
+	case COMMAND_LOAD:
+		if (gb_load_state_file(dbg->gb, "dump.sav"))
+			printf("Failed to load dump.sav\n");
 		break;
 	case COMMAND_CLEAR:
 		debugger_clear(dbg);
 		break;
+	case COMMAND_REWIND:
+		if (!dbg->gb->rewind) {
+			printf("Rewind is disabled\n");
+			break;
+		}
+		printf("Rewind %u frames\n",
+		       rewind_step(dbg->gb->rewind, dbg->gb,
+				   dbg->command.counter));
+		sm83_info(&dbg->gb->cpu);
+		break;
+	case COMMAND_PROFILE:
+		profile_print(&dbg->gb->profile, stdout);
+		break;
 	case COMMAND_HELP:
 		print_help();
 		break;
@@ -198,107 +198,158 @@ static const char *OP_TABLES_CB_OP_2[256] = {
 	"H",  "L",  "HL", "A"
 };
 
-static int OPCODE_LENGTH[256] = {
-	/*      0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F */
-	/* 0 */ 1, 3, 1, 1, 1, 1, 2, 1, 3, 1, 1, 1, 1, 1, 2, 1,
-	/* 1 */ 2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
-	/* 2 */ 2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
-	/* 3 */ 2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
-	/* 4 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-	/* 5 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-	/* 6 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-	/* 7 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-	/* 8 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-	/* 9 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-	/* A */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-	/* B */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-	/* C */ 1, 1, 3, 3, 3, 1, 2, 1, 1, 1, 3, 2, 3, 3, 2, 1,
-	/* D */ 1, 1, 3, 0, 3, 1, 2, 1, 1, 1, 3, 0, 3, 0, 2, 1,
-	/* E */ 2, 1, 1, 0, 0, 1, 2, 1, 2, 1, 3, 0, 0, 0, 2, 1,
-	/* F */ 2, 1, 1, 1, 0, 1, 2, 1, 2, 1, 3, 1, 0, 0, 2, 1,
-};
-
-static int OPCODE_MACHINE_CYCLES[256] = {
-	1, 3, 2, 2, 1, 1, 2, 1, 5, 2, 2, 2, 1, 1, 2, 1, 1, 3, 2, 2, 1, 1, 2, 1,
-	3, 2, 2, 2, 1, 1, 2, 1, 2, 3, 2, 2, 1, 1, 2, 1, 2, 2, 2, 2, 1, 1, 2, 1,
-	2, 3, 2, 2, 3, 3, 3, 1, 2, 2, 2, 2, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1,
-	1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1,
-	1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1, 2, 2, 2, 2, 2, 2, 1, 2,
-	1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1,
-	1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1,
-	1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1,
-	2, 3, 3, 4, 3, 4, 2, 4, 2, 4, 3, 0, 3, 6, 2, 4, 2, 3, 3, 0, 3, 4, 2, 4,
-	2, 4, 3, 0, 3, 0, 2, 4, 3, 3, 2, 0, 0, 4, 2, 4, 4, 1, 4, 0, 0, 0, 2, 4,
-	3, 3, 2, 1, 0, 4, 2, 4, 3, 2, 4, 1, 0, 0, 2, 4
-};
+#define OP(opcode, length, cycles) { opcode, length, cycles, false }
+#define CB(opcode, cycles) { opcode, 2, cycles, true }
 
-static int OPCODE_CB_MACHINE_CYCLES[256] = {
-	2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2,
-	2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2,
-	2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 3, 2,
-	2, 2, 2, 2, 2, 2, 3, 2, 2, 2, 2, 2, 2, 2, 3, 2, 2, 2, 2, 2, 2, 2, 3, 2,
-	2, 2, 2, 2, 2, 2, 3, 2, 2, 2, 2, 2, 2, 2, 3, 2, 2, 2, 2, 2, 2, 2, 3, 2,
-	2, 2, 2, 2, 2, 2, 3, 2, 2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2,
-	2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2,
-	2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2,
-	2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2,
-	2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2,
-	2, 2, 2, 2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 4, 2
+// clang-format off
+const struct sm83_instruction sm83_instructions[512] = {
+	OP(0x00, 1, 1), OP(0x01, 3, 3), OP(0x02, 1, 2), OP(0x03, 1, 2),
+	OP(0x04, 1, 1), OP(0x05, 1, 1), OP(0x06, 2, 2), OP(0x07, 1, 1),
+	OP(0x08, 3, 5), OP(0x09, 1, 2), OP(0x0A, 1, 2), OP(0x0B, 1, 2),
+	OP(0x0C, 1, 1), OP(0x0D, 1, 1), OP(0x0E, 2, 2), OP(0x0F, 1, 1),
+	OP(0x10, 2, 1), OP(0x11, 3, 3), OP(0x12, 1, 2), OP(0x13, 1, 2),
+	OP(0x14, 1, 1), OP(0x15, 1, 1), OP(0x16, 2, 2), OP(0x17, 1, 1),
+	OP(0x18, 2, 3), OP(0x19, 1, 2), OP(0x1A, 1, 2), OP(0x1B, 1, 2),
+	OP(0x1C, 1, 1), OP(0x1D, 1, 1), OP(0x1E, 2, 2), OP(0x1F, 1, 1),
+	OP(0x20, 2, 2), OP(0x21, 3, 3), OP(0x22, 1, 2), OP(0x23, 1, 2),
+	OP(0x24, 1, 1), OP(0x25, 1, 1), OP(0x26, 2, 2), OP(0x27, 1, 1),
+	OP(0x28, 2, 2), OP(0x29, 1, 2), OP(0x2A, 1, 2), OP(0x2B, 1, 2),
+	OP(0x2C, 1, 1), OP(0x2D, 1, 1), OP(0x2E, 2, 2), OP(0x2F, 1, 1),
+	OP(0x30, 2, 2), OP(0x31, 3, 3), OP(0x32, 1, 2), OP(0x33, 1, 2),
+	OP(0x34, 1, 3), OP(0x35, 1, 3), OP(0x36, 2, 3), OP(0x37, 1, 1),
+	OP(0x38, 2, 2), OP(0x39, 1, 2), OP(0x3A, 1, 2), OP(0x3B, 1, 2),
+	OP(0x3C, 1, 1), OP(0x3D, 1, 1), OP(0x3E, 2, 2), OP(0x3F, 1, 1),
+	OP(0x40, 1, 1), OP(0x41, 1, 1), OP(0x42, 1, 1), OP(0x43, 1, 1),
+	OP(0x44, 1, 1), OP(0x45, 1, 1), OP(0x46, 1, 2), OP(0x47, 1, 1),
+	OP(0x48, 1, 1), OP(0x49, 1, 1), OP(0x4A, 1, 1), OP(0x4B, 1, 1),
+	OP(0x4C, 1, 1), OP(0x4D, 1, 1), OP(0x4E, 1, 2), OP(0x4F, 1, 1),
+	OP(0x50, 1, 1), OP(0x51, 1, 1), OP(0x52, 1, 1), OP(0x53, 1, 1),
+	OP(0x54, 1, 1), OP(0x55, 1, 1), OP(0x56, 1, 2), OP(0x57, 1, 1),
+	OP(0x58, 1, 1), OP(0x59, 1, 1), OP(0x5A, 1, 1), OP(0x5B, 1, 1),
+	OP(0x5C, 1, 1), OP(0x5D, 1, 1), OP(0x5E, 1, 2), OP(0x5F, 1, 1),
+	OP(0x60, 1, 1), OP(0x61, 1, 1), OP(0x62, 1, 1), OP(0x63, 1, 1),
+	OP(0x64, 1, 1), OP(0x65, 1, 1), OP(0x66, 1, 2), OP(0x67, 1, 1),
+	OP(0x68, 1, 1), OP(0x69, 1, 1), OP(0x6A, 1, 1), OP(0x6B, 1, 1),
+	OP(0x6C, 1, 1), OP(0x6D, 1, 1), OP(0x6E, 1, 2), OP(0x6F, 1, 1),
+	OP(0x70, 1, 2), OP(0x71, 1, 2), OP(0x72, 1, 2), OP(0x73, 1, 2),
+	OP(0x74, 1, 2), OP(0x75, 1, 2), OP(0x76, 1, 1), OP(0x77, 1, 2),
+	OP(0x78, 1, 1), OP(0x79, 1, 1), OP(0x7A, 1, 1), OP(0x7B, 1, 1),
+	OP(0x7C, 1, 1), OP(0x7D, 1, 1), OP(0x7E, 1, 2), OP(0x7F, 1, 1),
+	OP(0x80, 1, 1), OP(0x81, 1, 1), OP(0x82, 1, 1), OP(0x83, 1, 1),
+	OP(0x84, 1, 1), OP(0x85, 1, 1), OP(0x86, 1, 2), OP(0x87, 1, 1),
+	OP(0x88, 1, 1), OP(0x89, 1, 1), OP(0x8A, 1, 1), OP(0x8B, 1, 1),
+	OP(0x8C, 1, 1), OP(0x8D, 1, 1), OP(0x8E, 1, 2), OP(0x8F, 1, 1),
+	OP(0x90, 1, 1), OP(0x91, 1, 1), OP(0x92, 1, 1), OP(0x93, 1, 1),
+	OP(0x94, 1, 1), OP(0x95, 1, 1), OP(0x96, 1, 2), OP(0x97, 1, 1),
+	OP(0x98, 1, 1), OP(0x99, 1, 1), OP(0x9A, 1, 1), OP(0x9B, 1, 1),
+	OP(0x9C, 1, 1), OP(0x9D, 1, 1), OP(0x9E, 1, 2), OP(0x9F, 1, 1),
+	OP(0xA0, 1, 1), OP(0xA1, 1, 1), OP(0xA2, 1, 1), OP(0xA3, 1, 1),
+	OP(0xA4, 1, 1), OP(0xA5, 1, 1), OP(0xA6, 1, 2), OP(0xA7, 1, 1),
+	OP(0xA8, 1, 1), OP(0xA9, 1, 1), OP(0xAA, 1, 1), OP(0xAB, 1, 1),
+	OP(0xAC, 1, 1), OP(0xAD, 1, 1), OP(0xAE, 1, 2), OP(0xAF, 1, 1),
+	OP(0xB0, 1, 1), OP(0xB1, 1, 1), OP(0xB2, 1, 1), OP(0xB3, 1, 1),
+	OP(0xB4, 1, 1), OP(0xB5, 1, 1), OP(0xB6, 1, 2), OP(0xB7, 1, 1),
+	OP(0xB8, 1, 1), OP(0xB9, 1, 1), OP(0xBA, 1, 1), OP(0xBB, 1, 1),
+	OP(0xBC, 1, 1), OP(0xBD, 1, 1), OP(0xBE, 1, 2), OP(0xBF, 1, 1),
+	OP(0xC0, 1, 2), OP(0xC1, 1, 3), OP(0xC2, 3, 3), OP(0xC3, 3, 4),
+	OP(0xC4, 3, 3), OP(0xC5, 1, 4), OP(0xC6, 2, 2), OP(0xC7, 1, 4),
+	OP(0xC8, 1, 2), OP(0xC9, 1, 4), OP(0xCA, 3, 3), OP(0xCB, 2, 0),
+	OP(0xCC, 3, 3), OP(0xCD, 3, 6), OP(0xCE, 2, 2), OP(0xCF, 1, 4),
+	OP(0xD0, 1, 2), OP(0xD1, 1, 3), OP(0xD2, 3, 3), OP(0xD3, 0, 0),
+	OP(0xD4, 3, 3), OP(0xD5, 1, 4), OP(0xD6, 2, 2), OP(0xD7, 1, 4),
+	OP(0xD8, 1, 2), OP(0xD9, 1, 4), OP(0xDA, 3, 3), OP(0xDB, 0, 0),
+	OP(0xDC, 3, 3), OP(0xDD, 0, 0), OP(0xDE, 2, 2), OP(0xDF, 1, 4),
+	OP(0xE0, 2, 3), OP(0xE1, 1, 3), OP(0xE2, 1, 2), OP(0xE3, 0, 0),
+	OP(0xE4, 0, 0), OP(0xE5, 1, 4), OP(0xE6, 2, 2), OP(0xE7, 1, 4),
+	OP(0xE8, 2, 4), OP(0xE9, 1, 1), OP(0xEA, 3, 4), OP(0xEB, 0, 0),
+	OP(0xEC, 0, 0), OP(0xED, 0, 0), OP(0xEE, 2, 2), OP(0xEF, 1, 4),
+	OP(0xF0, 2, 3), OP(0xF1, 1, 3), OP(0xF2, 1, 2), OP(0xF3, 1, 1),
+	OP(0xF4, 0, 0), OP(0xF5, 1, 4), OP(0xF6, 2, 2), OP(0xF7, 1, 4),
+	OP(0xF8, 2, 3), OP(0xF9, 1, 2), OP(0xFA, 3, 4), OP(0xFB, 1, 1),
+	OP(0xFC, 0, 0), OP(0xFD, 0, 0), OP(0xFE, 2, 2), OP(0xFF, 1, 4),
+	/* CB prefixed */
+	CB(0x00, 2), CB(0x01, 2), CB(0x02, 2), CB(0x03, 2),
+	CB(0x04, 2), CB(0x05, 2), CB(0x06, 4), CB(0x07, 2),
+	CB(0x08, 2), CB(0x09, 2), CB(0x0A, 2), CB(0x0B, 2),
+	CB(0x0C, 2), CB(0x0D, 2), CB(0x0E, 4), CB(0x0F, 2),
+	CB(0x10, 2), CB(0x11, 2), CB(0x12, 2), CB(0x13, 2),
+	CB(0x14, 2), CB(0x15, 2), CB(0x16, 4), CB(0x17, 2),
+	CB(0x18, 2), CB(0x19, 2), CB(0x1A, 2), CB(0x1B, 2),
+	CB(0x1C, 2), CB(0x1D, 2), CB(0x1E, 4), CB(0x1F, 2),
+	CB(0x20, 2), CB(0x21, 2), CB(0x22, 2), CB(0x23, 2),
+	CB(0x24, 2), CB(0x25, 2), CB(0x26, 4), CB(0x27, 2),
+	CB(0x28, 2), CB(0x29, 2), CB(0x2A, 2), CB(0x2B, 2),
+	CB(0x2C, 2), CB(0x2D, 2), CB(0x2E, 4), CB(0x2F, 2),
+	CB(0x30, 2), CB(0x31, 2), CB(0x32, 2), CB(0x33, 2),
+	CB(0x34, 2), CB(0x35, 2), CB(0x36, 4), CB(0x37, 2),
+	CB(0x38, 2), CB(0x39, 2), CB(0x3A, 2), CB(0x3B, 2),
+	CB(0x3C, 2), CB(0x3D, 2), CB(0x3E, 4), CB(0x3F, 2),
+	CB(0x40, 2), CB(0x41, 2), CB(0x42, 2), CB(0x43, 2),
+	CB(0x44, 2), CB(0x45, 2), CB(0x46, 3), CB(0x47, 2),
+	CB(0x48, 2), CB(0x49, 2), CB(0x4A, 2), CB(0x4B, 2),
+	CB(0x4C, 2), CB(0x4D, 2), CB(0x4E, 3), CB(0x4F, 2),
+	CB(0x50, 2), CB(0x51, 2), CB(0x52, 2), CB(0x53, 2),
+	CB(0x54, 2), CB(0x55, 2), CB(0x56, 3), CB(0x57, 2),
+	CB(0x58, 2), CB(0x59, 2), CB(0x5A, 2), CB(0x5B, 2),
+	CB(0x5C, 2), CB(0x5D, 2), CB(0x5E, 3), CB(0x5F, 2),
+	CB(0x60, 2), CB(0x61, 2), CB(0x62, 2), CB(0x63, 2),
+	CB(0x64, 2), CB(0x65, 2), CB(0x66, 3), CB(0x67, 2),
+	CB(0x68, 2), CB(0x69, 2), CB(0x6A, 2), CB(0x6B, 2),
+	CB(0x6C, 2), CB(0x6D, 2), CB(0x6E, 3), CB(0x6F, 2),
+	CB(0x70, 2), CB(0x71, 2), CB(0x72, 2), CB(0x73, 2),
+	CB(0x74, 2), CB(0x75, 2), CB(0x76, 3), CB(0x77, 2),
+	CB(0x78, 2), CB(0x79, 2), CB(0x7A, 2), CB(0x7B, 2),
+	CB(0x7C, 2), CB(0x7D, 2), CB(0x7E, 3), CB(0x7F, 2),
+	CB(0x80, 2), CB(0x81, 2), CB(0x82, 2), CB(0x83, 2),
+	CB(0x84, 2), CB(0x85, 2), CB(0x86, 4), CB(0x87, 2),
+	CB(0x88, 2), CB(0x89, 2), CB(0x8A, 2), CB(0x8B, 2),
+	CB(0x8C, 2), CB(0x8D, 2), CB(0x8E, 4), CB(0x8F, 2),
+	CB(0x90, 2), CB(0x91, 2), CB(0x92, 2), CB(0x93, 2),
+	CB(0x94, 2), CB(0x95, 2), CB(0x96, 4), CB(0x97, 2),
+	CB(0x98, 2), CB(0x99, 2), CB(0x9A, 2), CB(0x9B, 2),
+	CB(0x9C, 2), CB(0x9D, 2), CB(0x9E, 4), CB(0x9F, 2),
+	CB(0xA0, 2), CB(0xA1, 2), CB(0xA2, 2), CB(0xA3, 2),
+	CB(0xA4, 2), CB(0xA5, 2), CB(0xA6, 4), CB(0xA7, 2),
+	CB(0xA8, 2), CB(0xA9, 2), CB(0xAA, 2), CB(0xAB, 2),
+	CB(0xAC, 2), CB(0xAD, 2), CB(0xAE, 4), CB(0xAF, 2),
+	CB(0xB0, 2), CB(0xB1, 2), CB(0xB2, 2), CB(0xB3, 2),
+	CB(0xB4, 2), CB(0xB5, 2), CB(0xB6, 4), CB(0xB7, 2),
+	CB(0xB8, 2), CB(0xB9, 2), CB(0xBA, 2), CB(0xBB, 2),
+	CB(0xBC, 2), CB(0xBD, 2), CB(0xBE, 4), CB(0xBF, 2),
+	CB(0xC0, 2), CB(0xC1, 2), CB(0xC2, 2), CB(0xC3, 2),
+	CB(0xC4, 2), CB(0xC5, 2), CB(0xC6, 4), CB(0xC7, 2),
+	CB(0xC8, 2), CB(0xC9, 2), CB(0xCA, 2), CB(0xCB, 2),
+	CB(0xCC, 2), CB(0xCD, 2), CB(0xCE, 4), CB(0xCF, 2),
+	CB(0xD0, 2), CB(0xD1, 2), CB(0xD2, 2), CB(0xD3, 2),
+	CB(0xD4, 2), CB(0xD5, 2), CB(0xD6, 4), CB(0xD7, 2),
+	CB(0xD8, 2), CB(0xD9, 2), CB(0xDA, 2), CB(0xDB, 2),
+	CB(0xDC, 2), CB(0xDD, 2), CB(0xDE, 4), CB(0xDF, 2),
+	CB(0xE0, 2), CB(0xE1, 2), CB(0xE2, 2), CB(0xE3, 2),
+	CB(0xE4, 2), CB(0xE5, 2), CB(0xE6, 4), CB(0xE7, 2),
+	CB(0xE8, 2), CB(0xE9, 2), CB(0xEA, 2), CB(0xEB, 2),
+	CB(0xEC, 2), CB(0xED, 2), CB(0xEE, 4), CB(0xEF, 2),
+	CB(0xF0, 2), CB(0xF1, 2), CB(0xF2, 2), CB(0xF3, 2),
+	CB(0xF4, 2), CB(0xF5, 2), CB(0xF6, 4), CB(0xF7, 2),
+	CB(0xF8, 2), CB(0xF9, 2), CB(0xFA, 2), CB(0xFB, 2),
+	CB(0xFC, 2), CB(0xFD, 2), CB(0xFE, 4), CB(0xFF, 2),
 };
+// clang-format on
 
-static struct sm83_instruction cpu_decode_non_prefixed(u8 opcode)
-{
-	struct sm83_instruction instruction;
-
-	instruction.opcode = opcode;
-	instruction.length = OPCODE_LENGTH[opcode];
-	instruction.mnemonic = OP_TABLES_MNEMONIC[opcode];
-	instruction.op1 = OP_TABLES_OP_1[opcode];
-	instruction.op2 = OP_TABLES_OP_2[opcode];
-	instruction.cycles = OPCODE_MACHINE_CYCLES[opcode];
-	instruction.prefixed = false;
-	return instruction;
-}
-
-static struct sm83_instruction cpu_decode_prefixed(u8 opcode)
-{
-	struct sm83_instruction instruction;
-
-	instruction.opcode = opcode;
-	instruction.length = 2;
-	instruction.mnemonic = OP_TABLES_CB_MNEMONIC[opcode];
-	instruction.op1 = OP_TABLES_CB_OP_1[opcode];
-	instruction.op2 = OP_TABLES_CB_OP_2[opcode];
-	instruction.cycles = OPCODE_CB_MACHINE_CYCLES[opcode];
-	instruction.prefixed = true;
-	return instruction;
-}
-
-struct sm83_instruction sm83_decode(struct sm83_core *cpu)
-{
-	struct sm83_instruction instruction;
-
-	if (cpu->bus == 0xCB) {
-		instruction = cpu_decode_prefixed(
-			cpu->memory.load8(cpu, cpu->pc + 1));
-	} else {
-		instruction = cpu_decode_non_prefixed(cpu->bus);
-	}
-	return instruction;
-}
+#undef OP
+#undef CB
 
 void sm83_resolve_operand(struct sm83_core *cpu, const char *op, u16 indice,
 			  char *buffer)
 {
 	if (!strcmp(op, "a16") || !strcmp(op, "n16")) {
-		u16 segment = unsigned_16(cpu->memory.load8(cpu, indice + 1),
-					  cpu->memory.load8(cpu, indice + 2));
+		u16 segment = unsigned_16(sm83_load8(cpu, indice + 1),
+					  sm83_load8(cpu, indice + 2));
 		sprintf(buffer, "%s[$%04X]", op, segment);
 	} else if (!strcmp(op, "a8") || !strcmp(op, "n8")) {
 		sprintf(buffer, "%s[$%02X]", op,
-			cpu->memory.load8(cpu, indice + 1));
+			sm83_load8(cpu, indice + 1));
 	} else if (!strcmp(op, "e8")) {
-		u8 byte = cpu->memory.load8(cpu, indice + 1);
+		u8 byte = sm83_load8(cpu, indice + 1);
 		s8 offset = (s8)byte;
 		sprintf(buffer, "%s[$%02X] [%d]", op, byte, offset);
 	} else {
@@ -326,7 +377,7 @@ void sm83_info(struct sm83_core *cpu)
 {
 	char disasm[256];
 	printf("  A = $%1$02X [%1$08b] |  F = $%2$02X [%2$08b]\n", cpu->a,
-	       cpu->f);
+	       sm83_flags(cpu));
 	printf("  B = $%1$02X [%1$08b] |  C = $%2$02X [%2$08b]\n", cpu->b,
 	       cpu->c);
 	printf("  D = $%1$02X [%1$08b] |  E = $%2$02X [%2$08b]\n", cpu->d,
@@ -342,7 +393,7 @@ void sm83_info(struct sm83_core *cpu)
 	printf(" IME = %3d | HALT = %3d | DMA = %3d\n", cpu->ime, cpu->halted,
 	       cpu->dma.scheduled);
 	printf(" DIV = %3d | TIMA = %3d | M-cycles = %lu\n",
-	       cpu->memory.load8(cpu, DIV), cpu->memory.load8(cpu, TIMA),
+	       sm83_load8(cpu, DIV), sm83_load8(cpu, TIMA),
 	       cpu->cycles);
 	printf(" State = %s | DMA remaining: %d\n",
 	       sm83_state_names[cpu->state], cpu->dma.remaining);
@@ -353,7 +404,7 @@ void sm83_info(struct sm83_core *cpu)
 void sm83_memory_io_debug(struct sm83_core *cpu)
 {
 	for (int i = 0xFF00; i <= 0xFFFF; i++) {
-		u8 byte = cpu->memory.load8(cpu, i);
+		u8 byte = sm83_load8(cpu, i);
 		printf("%04X : %02X [%08b] %d\n", i, byte, byte, byte);
 	}
 }
@@ -361,8 +412,8 @@ void sm83_memory_io_debug(struct sm83_core *cpu)
 void sm83_memory_debug(struct sm83_core *cpu, u16 start, u16 end)
 {
 	for (int i = start; i <= end; i++) {
-		if (cpu->memory.load8(cpu, start + i) != 0)
-			printf("%02X", cpu->memory.load8(cpu, start + i));
+		if (sm83_load8(cpu, start + i) != 0)
+			printf("%02X", sm83_load8(cpu, start + i));
 		else
 			printf("..");
 		if ((i + 1) % 32 == 0 && i > 0)
@@ -373,27 +424,49 @@ void sm83_memory_debug(struct sm83_core *cpu, u16 start, u16 end)
 	printf("\n");
 }
 
+const char *sm83_mnemonic(const struct sm83_instruction *instruction)
+{
+	if (instruction->prefixed)
+		return OP_TABLES_CB_MNEMONIC[instruction->opcode];
+	return OP_TABLES_MNEMONIC[instruction->opcode];
+}
+
 void sm83_disassemble(struct sm83_core *cpu, char *buffer)
 {
 	char op1[256];
 	char op2[256];
-	struct sm83_instruction curr = cpu->instruction;
+	const struct sm83_instruction *curr = cpu->instruction;
+	const char *mnemonic;
+	const char *operand1;
+	const char *operand2;
 
+	// The CB descriptor is only selected once the second byte is fetched
+	if (!curr->prefixed && curr->opcode == 0xCB)
+		curr = sm83_decode(sm83_load8(cpu, cpu->index + 1), true);
+	if (curr->prefixed) {
+		mnemonic = OP_TABLES_CB_MNEMONIC[curr->opcode];
+		operand1 = OP_TABLES_CB_OP_1[curr->opcode];
+		operand2 = OP_TABLES_CB_OP_2[curr->opcode];
+	} else {
+		mnemonic = OP_TABLES_MNEMONIC[curr->opcode];
+		operand1 = OP_TABLES_OP_1[curr->opcode];
+		operand2 = OP_TABLES_OP_2[curr->opcode];
+	}
 	sprintf(buffer + strlen(buffer), "00:%04X", cpu->index);
-	for (int i = 0; i < curr.length; i++) {
+	for (int i = 0; i < curr->length; i++) {
 		sprintf(buffer + strlen(buffer), " %02X",
-			cpu->memory.load8(cpu, cpu->index + i));
+			sm83_load8(cpu, cpu->index + i));
 	}
 	sprintf(buffer + strlen(buffer), " -> ");
-	if (curr.op1 && curr.op2) {
-		sm83_resolve_operand(cpu, curr.op1, cpu->index, op1);
-		sm83_resolve_operand(cpu, curr.op2, cpu->index, op2);
-		sprintf(buffer + strlen(buffer), "%s %s %s", curr.mnemonic, op1,
+	if (operand1 && operand2) {
+		sm83_resolve_operand(cpu, operand1, cpu->index, op1);
+		sm83_resolve_operand(cpu, operand2, cpu->index, op2);
+		sprintf(buffer + strlen(buffer), "%s %s %s", mnemonic, op1,
 			op2);
-	} else if (curr.op1) {
-		sm83_resolve_operand(cpu, curr.op1, cpu->index, op1);
-		sprintf(buffer + strlen(buffer), "%s %s", curr.mnemonic, op1);
+	} else if (operand1) {
+		sm83_resolve_operand(cpu, operand1, cpu->index, op1);
+		sprintf(buffer + strlen(buffer), "%s %s", mnemonic, op1);
 	} else {
-		sprintf(buffer + strlen(buffer), "%s", curr.mnemonic);
+		sprintf(buffer + strlen(buffer), "%s", mnemonic);
 	}
 }
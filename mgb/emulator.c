@@ -0,0 +1,421 @@
+#include "platform/mm.h"
+#include "mgb/emulator.h"
+#include "mgb/joypad.h"
+#include "mgb/movie.h"
+#include "mgb/rewind.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void gb_schedule_ppu(struct gb_emulator *gb)
+{
+	scheduler_schedule(&gb->scheduler, EVENT_PPU,
+			   ppu_next_event(&gb->gpu, &gb->cpu));
+}
+
+static void gb_schedule_timer(struct gb_emulator *gb)
+{
+	scheduler_schedule(&gb->scheduler, EVENT_TIMER, gb->cpu.timer.overflow);
+}
+
+// Fallback for the VBlank latch, only fires when no frame was drawn for
+// a whole frame period
+static void gb_schedule_input(struct gb_emulator *gb)
+{
+	scheduler_schedule(&gb->scheduler, EVENT_INPUT,
+			   gb->cpu.cycles +
+				   GB_VIDEO_FRAME_PERIOD / gb->cpu.multiplier);
+}
+
+static void gb_latch_keys(struct gb_emulator *gb);
+
+void gb_run_events(struct gb_emulator *gb)
+{
+	while (scheduler_next(&gb->scheduler) <= gb->cpu.cycles) {
+		// A polling loop may read something new from here
+		gb->cpu.idle.valid = false;
+		switch (scheduler_pop(&gb->scheduler)) {
+		case EVENT_PPU:
+			PROFILE_ENTER(&gb->profile, PROFILE_PPU);
+			ppu_sync(&gb->gpu, &gb->cpu, gb->cpu.cycles);
+			gb_schedule_ppu(gb);
+			PROFILE_LEAVE(&gb->profile);
+			break;
+		case EVENT_TIMER:
+			PROFILE_ENTER(&gb->profile, PROFILE_TIMER);
+			sm83_timer_update(&gb->cpu);
+			gb_schedule_timer(gb);
+			PROFILE_LEAVE(&gb->profile);
+			break;
+		case EVENT_INPUT:
+			// No VBlank while the LCD is off, keys are still
+			// latched once per frame period
+			if (gb->memory.ram[LCDC_LCD] & (1 << LCD_ENABLE))
+				gb_schedule_input(gb);
+			else
+				gb_latch_keys(gb);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+static u8 gb_bus_load(struct sm83_core *cpu, u16 addr)
+{
+	struct gb_emulator *gb = (struct gb_emulator *)cpu->parent;
+	switch (addr) {
+	case P1_JOYP:
+		return update_joypad(gb);
+	case DIV:
+	case TIMA:
+		return sm83_timer_load(cpu, addr);
+	case CARTRIDGE_RAM_START ... 0xBFFF:
+		return cartridge_load_ram(&gb->cartridge, addr);
+	// case 0xC000 ... 0xDE00:
+	// 	addr += 0x2000;
+	}
+	return gb->memory.ram[addr];
+}
+
+static void gb_bus_write(struct sm83_core *cpu, u16 addr, u8 value)
+{
+	struct gb_emulator *gb = (struct gb_emulator *)cpu->parent;
+	if (gb->dirty.pages[addr >> MEMORY_PAGE_SHIFT] &&
+	    gb_dirty_fault(gb, addr, value))
+		return;
+	switch (addr) {
+	case 0x0000 ... 0x7FFF: {
+		u8 *sram = gb->cartridge.sram;
+		cartridge_write(&gb->cartridge, addr, value);
+		cartridge_map(&gb->cartridge, &cpu->memory, false);
+		if (gb->cartridge.sram != sram)
+			gb_dirty_remap(gb);
+		return;
+	}
+	case CARTRIDGE_RAM_START ... 0xBFFF:
+		cartridge_write_ram(&gb->cartridge, addr, value);
+		return;
+	case P1_JOYP: {
+		gb->memory.ram[P1_JOYP] = value | 0x0f;
+		update_joypad(gb);
+		break;
+	}
+	case DIV:
+	case TIMA:
+	case TAC:
+		sm83_timer_write(cpu, addr, value);
+		gb_schedule_timer(gb);
+		break;
+	case LCDC_LCD:
+		// Dots only run while the LCD is on, the PPU catches up to the
+		// previous cycle with the current value
+		ppu_sync(&gb->gpu, cpu, cpu->cycles - cpu->multiplier);
+		ppu_write_control(&gb->gpu, value);
+		gb_schedule_ppu(gb);
+		break;
+	case LY_LCD:
+		return;
+	case STAT_LCD: {
+		u8 stat = gb->memory.ram[STAT_LCD];
+		gb->memory.ram[addr] = (stat & 0x7) | (value & 0xf8);
+		break;
+	}
+	case DMA_OAM_DMA: {
+		// Starting DMA transfer
+		sm83_schedule_dma_transfer(cpu, value * 0x100);
+		return;
+	}
+	case IF:
+	case IE:
+		gb->memory.ram[addr] = value;
+		sm83_irq_refresh(cpu);
+		break;
+	// case 0xC000 ... 0xDE00:
+	// 	gb->memory.ram[addr] = value;
+	// 	gb->memory.ram[addr + 0x2000] = value;
+	// case 0xE000 ... 0xFE00:
+	// 	gb->memory.ram[addr] = value;
+	// 	gb->memory.ram[addr - 0x2000] = value;
+	default:
+		gb->memory.ram[addr] = value;
+	}
+}
+
+static u8 gb_cpu_load(struct sm83_core *cpu, u16 addr)
+{
+	u8 value;
+
+	PROFILE_ENTER(cpu->profile, PROFILE_MEMORY);
+	value = gb_bus_load(cpu, addr);
+	PROFILE_LEAVE(cpu->profile);
+	return value;
+}
+
+static void gb_cpu_write(struct sm83_core *cpu, u16 addr, u8 value)
+{
+	PROFILE_ENTER(cpu->profile, PROFILE_MEMORY);
+	gb_bus_write(cpu, addr, value);
+	PROFILE_LEAVE(cpu->profile);
+}
+
+static void gb_cpu_sync(struct sm83_core *cpu)
+{
+	gb_run_events((struct gb_emulator *)cpu->parent);
+}
+
+static u8 *gb_load_offset(struct ppu *gpu, u16 offset)
+{
+	return ((struct gb_emulator*)gpu->parent)->memory.ram + offset;
+}
+
+static u8 gb_gpu_read(struct ppu *gpu, u16 addr)
+{
+	return ((struct gb_emulator*)gpu->parent)->memory.ram[addr];
+}
+
+static void gb_gpu_write(struct ppu *gpu, u16 addr, u8 value)
+{
+	((struct gb_emulator*)gpu->parent)->memory.ram[addr] = value;
+}
+
+static void gb_gpu_interrupt(struct ppu *gpu, enum sm83_irq number)
+{
+	sm83_irq_request(&((struct gb_emulator *)gpu->parent)->cpu, number);
+}
+
+// Keys only change once per frame, at VBlank or from EVENT_INPUT while the
+// LCD is off. They come from the host or from the movie being replayed,
+// so a run is reproduced from the keys of every frame.
+static void gb_latch_keys(struct gb_emulator *gb)
+{
+	u8 keys = atomic_load_explicit(&gb->input, memory_order_relaxed);
+
+	gb_schedule_input(gb);
+	if (gb->movie)
+		keys = movie_update(gb->movie, gb, keys);
+	if (keys == gb->keys)
+		return;
+	gb->keys = keys;
+	update_joypad(gb);
+}
+
+static void gb_gpu_vblank(struct ppu *gpu)
+{
+	struct gb_emulator *gb = (struct gb_emulator *)gpu->parent;
+	gb_latch_keys(gb);
+	if (gb->rewind)
+		gb->rewind->pending = true;
+	if (gb->vblank) {
+		PROFILE_ENTER(&gb->profile, PROFILE_HOST);
+		gb->vblank(gb, gb->vblank_data);
+		PROFILE_LEAVE(&gb->profile);
+	}
+}
+
+static void map_memory(struct gb_emulator *gb)
+{
+	for (int i = 0; i < MEMORY_PAGE_COUNT; i++) {
+		u8 *page = gb->memory.ram + (i << MEMORY_PAGE_SHIFT);
+		// Hardware registers page goes through gb_cpu_load/gb_cpu_write,
+		// the cartridge maps its own pages once loaded
+		bool io = i == (P1_JOYP >> MEMORY_PAGE_SHIFT) ||
+			  i < (0x8000 >> MEMORY_PAGE_SHIFT) ||
+			  (i >= (CARTRIDGE_RAM_START >> MEMORY_PAGE_SHIFT) &&
+			   i < (0xC000 >> MEMORY_PAGE_SHIFT));
+		gb->cpu.memory.load_pages[i] = io ? NULL : page;
+		gb->cpu.memory.write_pages[i] = io ? NULL : page;
+		gb->gpu.ram.pages[i] = page;
+	}
+	gb->cpu.memory.io = gb->memory.ram + P1_JOYP;
+}
+
+static void init_devices(struct gb_emulator *gb)
+{
+	sm83_cpu_reset(&gb->cpu);
+	gb->cpu.parent = gb;
+	gb->cpu.memory.load8 = gb_cpu_load;
+	gb->cpu.memory.write8 = gb_cpu_write;
+	gb->cpu.memory.sync = gb_cpu_sync;
+	gb->cpu.profile = &gb->profile;
+	ppu_init(&gb->gpu);
+	gb->gpu.parent = gb;
+	gb->gpu.ram.load = gb_gpu_read;
+	gb->gpu.ram.write = gb_gpu_write;
+	gb->gpu.ram.offset = gb_load_offset;
+	gb->gpu.vblank = gb_gpu_vblank;
+	gb->gpu.interrupt = gb_gpu_interrupt;
+	gb->gpu.profile = &gb->profile;
+	gb->gpu.width = 256 + GB_WIDTH;
+	gb->gpu.height = 512;
+	map_memory(gb);
+	scheduler_init(&gb->scheduler);
+	gb_schedule_ppu(gb);
+	gb_schedule_timer(gb);
+	gb_schedule_input(gb);
+}
+
+struct gb_emulator *init_gb_emulator(void)
+{
+	struct gb_emulator *gb;
+	gb = (struct gb_emulator *)calloc(1, sizeof(struct gb_emulator));
+	if (!gb)
+		return NULL;
+	profile_reset(&gb->profile);
+	atomic_init(&gb->input, 0);
+	init_devices(gb);
+	return gb;
+}
+
+void destroy_gb_emulator(struct gb_emulator *gb)
+{
+	gb_snapshot_release(gb->snapshot);
+	cartridge_release(&gb->cartridge);
+	zfree(gb);
+}
+
+// Power cycle, the cartridge keeps its mapped image and battery RAM
+void gb_reset(struct gb_emulator *gb)
+{
+	bool dma_enabled = gb->cpu.dma_enabled;
+
+	gb_dirty_reset(gb);
+	memset(gb->memory.ram, 0, sizeof(gb->memory.ram));
+	init_devices(gb);
+	gb->cpu.dma_enabled = dma_enabled;
+	cartridge_reset(&gb->cartridge);
+	cartridge_map(&gb->cartridge, &gb->cpu.memory, true);
+}
+
+int gb_load_rom(struct gb_emulator *gb, const char *path)
+{
+	if (cartridge_load(&gb->cartridge, path))
+		return -1;
+	cartridge_map(&gb->cartridge, &gb->cpu.memory, true);
+	return 0;
+}
+
+// Interrupts are only raised by scheduled events, a halted core would
+// spin until the next one without changing anything else. Jump there.
+static void gb_skip_halt(struct gb_emulator *gb, u64 limit)
+{
+	u64 next = scheduler_next(&gb->scheduler);
+
+	if (next > limit)
+		next = limit;
+	PROFILE_SKIP(&gb->profile, SKIP_HALT, next - gb->cpu.cycles);
+	gb->cpu.cycles = next;
+}
+
+// A loop polling LY or STAT reads the same value until the next event.
+// Once an iteration with no event in it brings the registers back to
+// where they were, the following ones are skipped, as long as they
+// would end before the event so the one reading the new value still
+// runs.
+static void gb_skip_idle(struct gb_emulator *gb, u64 limit)
+{
+	struct sm83_core *cpu = &gb->cpu;
+	struct sm83_idle *idle = &cpu->idle;
+	u64 next = scheduler_next(&gb->scheduler);
+	u64 length, iterations;
+	u32 count;
+
+	if (!(count = sm83_idle_loop(cpu)))
+		return;
+	if (next > limit)
+		next = limit;
+	if (idle->valid && idle->pc == cpu->pc && idle->a == cpu->a &&
+	    idle->f == sm83_flags(cpu) &&
+	    cpu->instructions - idle->instructions == count &&
+	    !(cpu->ime && cpu->pending)) {
+		length = cpu->cycles - idle->cycles;
+		iterations = (next - cpu->cycles) / length;
+		if (iterations > 1) {
+			iterations--;
+			PROFILE_SKIP(&gb->profile, SKIP_IDLE,
+				     iterations * length);
+			cpu->cycles += iterations * length;
+			cpu->instructions += iterations * count;
+		}
+	}
+	idle->valid = true;
+	idle->pc = cpu->pc;
+	idle->a = cpu->a;
+	idle->f = sm83_flags(cpu);
+	idle->cycles = cpu->cycles;
+	idle->instructions = cpu->instructions;
+}
+
+static inline void gb_step(struct gb_emulator *gb, u64 limit, bool fast)
+{
+	struct sm83_core *cpu = &gb->cpu;
+
+	if (sm83_halt_idle(cpu)) {
+		gb_skip_halt(gb, limit);
+		return;
+	}
+	// Only a taken backward branch can close a polling loop
+	if (cpu->state == SM83_CORE_FETCH && cpu->pc < cpu->index)
+		gb_skip_idle(gb, limit);
+	if (fast)
+		sm83_cpu_run_instruction(cpu);
+	else
+		sm83_cpu_step(cpu);
+}
+
+u32 gb_run_until(struct gb_emulator *gb, u64 limit, bool fast)
+{
+	u64 start = gb->cpu.cycles;
+
+	// Run the core uninterrupted until the next event or the limit.
+	// Register writes can move the next deadline closer.
+	PROFILE_ENTER(&gb->profile, PROFILE_CPU);
+	while (gb->cpu.cycles < limit &&
+	       gb->cpu.cycles < scheduler_next(&gb->scheduler))
+		gb_step(gb, limit, fast);
+	PROFILE_LEAVE(&gb->profile);
+	gb_run_events(gb);
+	rewind_update(gb);
+	return gb->cpu.cycles - start;
+}
+
+struct gb_emulator *mgb_create(const char *rom_path)
+{
+	struct gb_emulator *gb;
+
+	if (!(gb = init_gb_emulator()))
+		return NULL;
+	if (gb_load_rom(gb, rom_path)) {
+		destroy_gb_emulator(gb);
+		return NULL;
+	}
+	gb->cpu.dma_enabled = true;
+	return gb;
+}
+
+u64 mgb_run_cycles(struct gb_emulator *gb, u64 cycles)
+{
+	u64 start = gb->cpu.cycles;
+	u64 limit = start + cycles;
+
+	while (gb->cpu.cycles < limit)
+		gb_run_until(gb, limit, true);
+	return gb->cpu.cycles - start;
+}
+
+// GB_WIDTH x GB_HEIGHT shades, from 0 (white) to 3 (black)
+const u8 *mgb_get_framebuffer(struct gb_emulator *gb)
+{
+	return gb->gpu.frame_buffer;
+}
+
+// One bit per pressed button, indexed by enum joypad_button. Latched at
+// the next VBlank, may be called from any thread.
+void mgb_set_input(struct gb_emulator *gb, u8 keys)
+{
+	atomic_store_explicit(&gb->input, keys, memory_order_relaxed);
+}
+
+void mgb_destroy(struct gb_emulator *gb)
+{
+	destroy_gb_emulator(gb);
+}
@@ -0,0 +1,33 @@
+#include "mgb/frame.h"
+#include <stddef.h>
+
+void frame_exchange_init(struct frame_exchange *exchange)
+{
+	exchange->back = 0;
+	atomic_init(&exchange->state, 1);
+	exchange->front = 2;
+}
+
+// Hand the back slot over, the producer gets the previous middle one
+void frame_exchange_publish(struct frame_exchange *exchange)
+{
+	unsigned state = atomic_exchange_explicit(&exchange->state,
+						  exchange->back | FRAME_FRESH,
+						  memory_order_acq_rel);
+	exchange->back = state & FRAME_INDEX;
+}
+
+// Latest finished frame, NULL when nothing was published since the last
+// call
+struct frame *frame_exchange_acquire(struct frame_exchange *exchange)
+{
+	unsigned state;
+
+	if (!(atomic_load_explicit(&exchange->state, memory_order_relaxed) &
+	      FRAME_FRESH))
+		return NULL;
+	state = atomic_exchange_explicit(&exchange->state, exchange->front,
+					 memory_order_acq_rel);
+	exchange->front = state & FRAME_INDEX;
+	return &exchange->slots[exchange->front];
+}
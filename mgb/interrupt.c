@@ -33,21 +33,13 @@ void debug_interrupt(struct sm83_core *cpu, struct interrupt_struct interrupt,
 
 u8 sm83_irq_ack(struct sm83_core *cpu)
 {
-	u8 irqs;
-	u8 if_reg;
+	int number;
 
-	if (!cpu->ime)
+	if (!cpu->ime || !cpu->pending)
 		return 0;
-	if_reg = cpu->memory.load8(cpu, IF);
-	irqs = cpu->memory.load8(cpu, IE) & if_reg;
-	for (int i = 0; i < ARRAY_SIZE(interrupts); i++) {
-		struct interrupt_struct interrupt = interrupts[i];
-		u8 bitmask = 1 << interrupt.number;
-		if ((irqs & bitmask) != 0) {
-			if_reg &= ~bitmask;
-			cpu->memory.write8(cpu, IF, if_reg);
-			return interrupt.vector;
-		}
-	}
-	return 0;
+	// Lowest bit first, interrupts[] is in the same order
+	number = __builtin_ctz(cpu->pending);
+	*sm83_io(cpu, IF) &= ~(1 << number);
+	sm83_irq_refresh(cpu);
+	return interrupts[number].vector;
 }
@@ -25,10 +25,13 @@ u8 read_keys(u8 keys, u8 joyp)
 u8 update_joypad(struct gb_emulator *gb)
 {
 	// https://gbdev.io/pandocs/Joypad_Input.html#ff00--p1joyp-joypad
-	u8 joypad = read_keys(gb->keys, gb->memory.ram[P1_JOYP]);
+	u8 previous = gb->memory.ram[P1_JOYP];
+	u8 joypad = read_keys(gb->keys, previous);
+
 	gb->memory.ram[P1_JOYP] = joypad;
-	if ((joypad & ~gb->memory.ram[P1_JOYP] & 0xF) != 0) {
-		gb->memory.ram[IF] |= (1 << IRQ_JOYPAD);
+	// Raised when an input line goes from high to low
+	if ((previous & ~joypad & 0xF) != 0) {
+		sm83_irq_request(&gb->cpu, IRQ_JOYPAD);
 	}
-	return gb->memory.ram[P1_JOYP];
+	return joypad;
 }
@@ -4,6 +4,27 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+// clang-format off
+const u8 dmg_boot_rom[DMG_BOOT_ROM_SIZE] = {
+	0x31, 0xfe, 0xff, 0xaf, 0x21, 0xff, 0x9f, 0x32, 0xcb, 0x7c, 0x20, 0xfb, 0x21, 0x26, 0xff, 0x0e,
+	0x11, 0x3e, 0x80, 0x32, 0xe2, 0x0c, 0x3e, 0xf3, 0xe2, 0x32, 0x3e, 0x77, 0x77, 0x3e, 0xfc, 0xe0,
+	0x47, 0x21, 0x04, 0x01, 0xe5, 0x11, 0xcb, 0x00, 0x1a, 0x13, 0xbe, 0x20, 0x6b, 0x23, 0x7d, 0xfe,
+	0x34, 0x20, 0xf5, 0x06, 0x19, 0x78, 0x86, 0x23, 0x05, 0x20, 0xfb, 0x86, 0x20, 0x5a, 0xd1, 0x21,
+	0x10, 0x80, 0x1a, 0xcd, 0xa9, 0x00, 0xcd, 0xaa, 0x00, 0x13, 0x7b, 0xfe, 0x34, 0x20, 0xf3, 0x3e,
+	0x18, 0x21, 0x2f, 0x99, 0x0e, 0x0c, 0x32, 0x3d, 0x28, 0x09, 0x0d, 0x20, 0xf9, 0x11, 0xec, 0xff,
+	0x19, 0x18, 0xf1, 0x67, 0x3e, 0x64, 0x57, 0xe0, 0x42, 0x3e, 0x91, 0xe0, 0x40, 0x04, 0x1e, 0x02,
+	0xcd, 0xbc, 0x00, 0x0e, 0x13, 0x24, 0x7c, 0x1e, 0x83, 0xfe, 0x62, 0x28, 0x06, 0x1e, 0xc1, 0xfe,
+	0x64, 0x20, 0x06, 0x7b, 0xe2, 0x0c, 0x3e, 0x87, 0xe2, 0xf0, 0x42, 0x90, 0xe0, 0x42, 0x15, 0x20,
+	0xdd, 0x05, 0x20, 0x69, 0x16, 0x20, 0x18, 0xd6, 0x3e, 0x91, 0xe0, 0x40, 0x1e, 0x14, 0xcd, 0xbc,
+	0x00, 0xf0, 0x47, 0xee, 0xff, 0xe0, 0x47, 0x18, 0xf3, 0x4f, 0x06, 0x04, 0xc5, 0xcb, 0x11, 0x17,
+	0xc1, 0xcb, 0x11, 0x17, 0x05, 0x20, 0xf5, 0x22, 0x23, 0x22, 0x23, 0xc9, 0x0e, 0x0c, 0xf0, 0x44,
+	0xfe, 0x90, 0x20, 0xfa, 0x0d, 0x20, 0xf7, 0x1d, 0x20, 0xf2, 0xc9, 0xce, 0xed, 0x66, 0x66, 0xcc,
+	0x0d, 0x00, 0x0b, 0x03, 0x73, 0x00, 0x83, 0x00, 0x0c, 0x00, 0x0d, 0x00, 0x08, 0x11, 0x1f, 0x88,
+	0x89, 0x00, 0x0e, 0xdc, 0xcc, 0x6e, 0xe6, 0xdd, 0xdd, 0xd9, 0x99, 0xbb, 0xbb, 0x67, 0x63, 0x6e,
+	0x0e, 0xec, 0xcc, 0xdd, 0xdc, 0x99, 0x9f, 0xbb, 0xb9, 0x33, 0x3e, 0xff, 0xff, 0x3c, 0xe0, 0x50,
+};
+// clang-format on
+
 void memory_reset(struct memory *mem)
 {
 	for (int i = 0; i <= 0xFFFF; i++) {
@@ -23,30 +44,6 @@ void memory_reset(struct memory *mem)
 	}
 }
 
-int load_rom(struct memory *mem, char *path)
-{
-	FILE *file;
-	size_t size_in_bytes;
-	u8 buffer[MEMORY_SIZE] = { 0 };
-	if (!mem)
-		return -1;
-	file = fopen(path, "r");
-	if (!file)
-		return -1;
-	size_in_bytes = fs_size(file);
-	if (size_in_bytes > MEMORY_SIZE)
-		goto err;
-	if (fread(buffer, sizeof(u8), MEMORY_SIZE, file) == 0)
-		goto err;
-	for (int i = 0; i < MEMORY_SIZE; i++)
-		mem->ram[i] = buffer[i];
-	fclose(file);
-	return 0;
-err:
-	fclose(file);
-	return -1;
-}
-
 void dump_memory(struct memory *mem)
 {
 	for (int i = 0; i <= MEMORY_SIZE; i++) {
@@ -65,33 +62,12 @@ void dump_memory(struct memory *mem)
 	printf("\n");
 }
 
-void dump_memory_to_file(struct memory *mem, char *filename)
-{
-	FILE *fptr;
-	fptr = fopen(filename, "w");
-	if (!fptr) {
-		printf("Failed to open %s\n", filename);
-		return;
-	}
-	if (!fwrite(mem->ram, MEMORY_SIZE, sizeof(u8), fptr)) {
-		printf("Failed to write save\n");
-	}
-	fclose(fptr);
-}
-
 void print_addr(struct memory *mem, u16 addr)
 {
 	u8 byte = mem->ram[addr];
 	printf("$%02X [%08b] %d\n", byte, byte, byte);
 }
 
-void request_interrupt(struct memory *mem, enum sm83_irq number)
-{
-	u8 irq_reqs = mem->ram[IF];
-	irq_reqs |= 1 << number;
-	mem->ram[IF] = irq_reqs;
-}
-
 struct hreg_print_helper {
 	const char *label;
 	const enum hardware_register addr;
@@ -2,6 +2,7 @@
 #include "platform/render.h"
 #include "mgb/mgb.h"
 #include "mgb/debugger.h"
+#include "mgb/state.h"
 #include <pthread.h>
 #include <raylib.h>
 #include <stdio.h>
@@ -9,100 +10,19 @@
 #include <signal.h>
 #include <string.h>
 
-static volatile int sigint_catcher = 0;
-
-static void sigint_handler(int dummy)
-{
-	sigint_catcher = 1;
-}
-
-static u8 gb_cpu_load(struct sm83_core *cpu, u16 addr)
-{
-	struct gb_emulator *gb = (struct gb_emulator *)cpu->parent;
-	switch (addr) {
-	case P1_JOYP:
-		return update_joypad(gb);
-	// case 0xC000 ... 0xDE00:
-	// 	addr += 0x2000;
-	}
-	return gb->memory.ram[addr];
-}
-
-static void gb_cpu_write(struct sm83_core *cpu, u16 addr, u8 value)
-{
-	struct gb_emulator *gb = (struct gb_emulator *)cpu->parent;
-	switch (addr) {
-	case P1_JOYP: {
-		gb->memory.ram[P1_JOYP] = value | 0x0f;
-		update_joypad(gb);
-		break;
-	}
-	case LY_LCD:
-		return;
-	case STAT_LCD: {
-		u8 stat = gb->memory.ram[STAT_LCD];
-		gb->memory.ram[addr] = (stat & 0x3) | (value & 0xfc);
-		break;
-	}
-	case DMA_OAM_DMA: {
-		// Starting DMA transfer
-		sm83_schedule_dma_transfer(cpu, value * 0x100);
-		return;
-	}
-	// case 0xC000 ... 0xDE00:
-	// 	gb->memory.ram[addr] = value;
-	// 	gb->memory.ram[addr + 0x2000] = value;
-	// case 0xE000 ... 0xFE00:
-	// 	gb->memory.ram[addr] = value;
-	// 	gb->memory.ram[addr - 0x2000] = value;
-	default:
-		gb->memory.ram[addr] = value;
-	}
-}
-
-static u8 *gb_load_offset(struct ppu *gpu, u16 offset)
-{
-	return ((struct gb_emulator*)gpu->parent)->memory.ram + offset;
-}
-
-static u8 gb_gpu_read(struct ppu *gpu, u16 addr)
-{
-	return ((struct gb_emulator*)gpu->parent)->memory.ram[addr];
-}
-
-static void gb_gpu_write(struct ppu *gpu, u16 addr, u8 value)
-{
-	((struct gb_emulator*)gpu->parent)->memory.ram[addr] = value;
-}
-
-static void init_devices(struct gb_emulator *gb)
-{
-	sm83_cpu_reset(&gb->cpu);
-	gb->cpu.parent = gb;
-	gb->cpu.memory.load8 = gb_cpu_load;
-	gb->cpu.memory.write8 = gb_cpu_write;
-	ppu_init(&gb->gpu);
-	gb->gpu.parent = gb;
-	gb->gpu.ram.load = gb_gpu_read;
-	gb->gpu.ram.write = gb_gpu_write;
-	gb->gpu.ram.offset = gb_load_offset;
-	gb->gpu.width = 256 + GB_WIDTH;
-	gb->gpu.height = 512;
-}
-
-static struct gb_emulator *init_gb_emulator()
+// SIGINT is blocked in every thread and consumed here, so the context
+// is reached without a global
+static void *run_signal_thread(void *arg)
 {
-	struct gb_emulator *gb;
-	gb = (struct gb_emulator *)malloc(sizeof(struct gb_emulator));
-	if (!gb)
-		return NULL;
-	init_devices(gb);
-	return gb;
-}
+	struct gb_context *ctx = arg;
+	sigset_t set;
+	int sig;
 
-static void destroy_gb_emulator(struct gb_emulator *gb)
-{
-	zfree(gb);
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	while (!sigwait(&set, &sig))
+		ctx->interrupted = 1;
+	return NULL;
 }
 
 static void gb_log_error(struct gb_context *ctx, char *msg)
@@ -111,24 +31,6 @@ static void gb_log_error(struct gb_context *ctx, char *msg)
 	ctx->exit_code = -1;
 }
 
-static void throttling(struct gb_context *ctx)
-{
-	unsigned long elapsed = 0;
-	struct timeval now, diff;
-	if (!ctx->gb->cpu.halted) {
-		ctx->cycles++;
-		// Throttling
-		if (ctx->cycles >= 17476) {
-			ctx->cycles -= 17476;
-			while (elapsed < GB_REALISTIC_CYCLES) {
-				gettimeofday(&now, NULL);
-				timersub(&now, &ctx->start_time, &diff);
-				elapsed = (unsigned long)diff.tv_usec * 1000;
-			}
-		}
-	}
-}
-
 static void bind_debugger(struct debugger *dbg, struct gb_context *ctx)
 {
 	debugger_new(dbg);
@@ -143,92 +45,329 @@ static void run_cpu_debugger(struct gb_context *ctx)
 	struct debugger dbg;
 	bind_debugger(&dbg, ctx);
 	while (dbg.state != STATE_QUIT) {
-		gettimeofday(&ctx->start_time, NULL);
-		if (sigint_catcher) {
+		if (ctx->interrupted) {
 			dbg.state = STATE_WAIT;
-			sigint_catcher = 0;
+			ctx->interrupted = 0;
 		}
 		if (debugger_step(&dbg))
 			break;
-		ppu_tick(&ctx->gb->gpu, &ctx->gb->cpu);
-		if (GB_FLAG(GB_THROTTLING))
-			throttling(ctx);
+		gb_run_events(ctx->gb);
+		rewind_update(ctx->gb);
+		pacing_update(&ctx->pacing, ctx->gb->cpu.multiplier);
 	}
 }
 
+static u32 run_emulator_step(struct gb_context *ctx)
+{
+	struct gb_emulator *gb = ctx->gb;
+
+	// At most a scanline so the loop keeps polling its flags
+	return gb_run_until(gb, gb->cpu.cycles + GB_VIDEO_SCANLINE_PERIOD,
+			    GB_FLAG(GB_FAST));
+}
+
+// One recorded frame back per frame period, shown like a regular frame
+static void run_rewind_step(struct gb_context *ctx)
+{
+	struct gb_emulator *gb = ctx->gb;
+
+	rewind_step(ctx->rewind, gb, 1);
+	if (gb->vblank)
+		gb->vblank(gb, gb->vblank_data);
+	pacing_update(&ctx->pacing, GB_VIDEO_FRAME_PERIOD);
+}
+
 static void *run_emulator_cpu_thread(void *arg)
 {
 	struct gb_context *ctx = arg;
-	signal(SIGINT, sigint_handler);
 	if (GB_FLAG(GB_DEBUG)) {
 		run_cpu_debugger(ctx);
 		GB_FLAG_DISABLE(GB_ON);
 	} else {
 		while (GB_FLAG(GB_ON)) {
-			gettimeofday(&ctx->start_time, NULL);
-			if (sigint_catcher)
+			// A replay stops once the movie is over
+			if (ctx->interrupted ||
+			    (ctx->movie && ctx->movie->ended))
 				GB_FLAG_DISABLE(GB_ON);
-			sm83_cpu_step(&ctx->gb->cpu);
-			ppu_tick(&ctx->gb->gpu, &ctx->gb->cpu);
-			if (GB_FLAG(GB_THROTTLING))
-				throttling(ctx);
+			if (ctx->rewinding && ctx->rewind) {
+				run_rewind_step(ctx);
+				continue;
+			}
+			pacing_update(&ctx->pacing, run_emulator_step(ctx));
 		}
 	}
 	pthread_exit(NULL);
 }
 
-static void draw(struct ppu *gpu, int x, int y, int color)
+enum gb_view_type {
+	GB_VIEW_LCD,
+	GB_VIEW_TILEDATA,
+	GB_VIEW_WINDOW,
+	GB_VIEW_BACKGROUND,
+	GB_VIEW_COUNT,
+};
+
+struct gb_view {
+	int x;
+	int y;
+	int width;
+	int height;
+	u32 *pixels;
+	Texture2D texture;
+};
+
+// Textures uploaded to the host, the debug views are only rebuilt when
+// VRAM or LCDC changed since the last upload
+struct gb_screen {
+	struct gb_view views[GB_VIEW_COUNT];
+	struct frame *frame;
+	u8 lcdc;
+	u8 vram[GB_VRAM_SIZE];
+};
+
+static int screen_init(struct gb_screen *screen)
+{
+	// clang-format off
+	struct gb_view layout[GB_VIEW_COUNT] = {
+		{ 0, 0, GB_WIDTH, GB_HEIGHT },
+		{ 0, GB_HEIGHT, GB_TILEDATA_WIDTH, GB_TILEDATA_HEIGHT },
+		{ GB_WIDTH, 0, GB_BG_MAP_WIDTH, GB_BG_MAP_HEIGHT },
+		{ GB_WIDTH, GB_BG_MAP_HEIGHT, GB_BG_MAP_WIDTH, GB_BG_MAP_HEIGHT },
+	};
+	// clang-format on
+
+	// Force a first upload of the debug views
+	screen->frame = NULL;
+	screen->lcdc = 0;
+	memset(screen->vram, 0xFF, sizeof(screen->vram));
+	for (int i = 0; i < GB_VIEW_COUNT; i++) {
+		struct gb_view *view = &screen->views[i];
+		*view = layout[i];
+		view->pixels = calloc(view->width * view->height, sizeof(u32));
+		if (!view->pixels)
+			return -1;
+		view->texture = render_texture_create(view->width, view->height);
+	}
+	return 0;
+}
+
+static void screen_update(struct gb_screen *screen,
+			  struct frame_exchange *exchange)
 {
-	render_pixel(x, y, color, gpu->scale);
+	struct gb_view *views = screen->views;
+	struct frame *frame = frame_exchange_acquire(exchange);
+
+	if (!frame)
+		return;
+	screen->frame = frame;
+	ppu_blit_frame(frame->pixels, views[GB_VIEW_LCD].pixels);
+	render_texture_update(views[GB_VIEW_LCD].texture,
+			      views[GB_VIEW_LCD].pixels);
+	if (screen->lcdc == frame->lcdc &&
+	    !memcmp(screen->vram, frame->vram, GB_VRAM_SIZE))
+		return;
+	screen->lcdc = frame->lcdc;
+	memcpy(screen->vram, frame->vram, GB_VRAM_SIZE);
+	ppu_blit_tiledata(frame->vram, views[GB_VIEW_TILEDATA].pixels);
+	ppu_blit_tilemap(frame->vram, frame->lcdc, VRAM_AREA_WINDOW_TILEMAP,
+			 views[GB_VIEW_WINDOW].pixels);
+	ppu_blit_tilemap(frame->vram, frame->lcdc, VRAM_AREA_BG_TILEMAP,
+			 views[GB_VIEW_BACKGROUND].pixels);
+	for (int i = GB_VIEW_TILEDATA; i < GB_VIEW_COUNT; i++)
+		render_texture_update(views[i].texture, views[i].pixels);
 }
 
-static void draw_debug_gui(struct ppu *gpu, struct gb_context *ctx)
+static void screen_draw(struct gb_screen *screen, int scale)
 {
-	render_debug("Dots: %d", gpu->dots, 20, gpu->scale * 384, 20);
-	render_debug("Frames: %d", gpu->frames, 20, gpu->scale * 404, 20);
-	render_debug("LY: %d", gpu->ly, 20, gpu->scale * 424, 20);
-	render_debug("Cycles: %d", ctx->gb->cpu.cycles, 20, ctx->scale * 444,
+	if (!screen->frame)
+		return;
+	for (int i = 0; i < GB_VIEW_COUNT; i++) {
+		struct gb_view *view = &screen->views[i];
+		render_texture_draw(view->texture, view->x, view->y, scale);
+	}
+}
+
+static void screen_release(struct gb_screen *screen)
+{
+	for (int i = 0; i < GB_VIEW_COUNT; i++) {
+		struct gb_view *view = &screen->views[i];
+		if (!view->pixels)
+			continue;
+		render_texture_release(view->texture);
+		zfree(view->pixels);
+	}
+}
+
+static void draw_debug_gui(struct gb_context *ctx, struct gb_screen *screen,
+			   int scale)
+{
+	if (!screen->frame)
+		return;
+	render_debug("Frames: %d", screen->frame->number, 20, scale * 404, 20);
+	render_debug("Cycles: %d", screen->frame->cycles, 20, scale * 424,
 		     20);
+	render_debug("Speed: %d%%",
+		     atomic_load_explicit(&ctx->pacing.percent,
+					  memory_order_relaxed),
+		     20, scale * 444, 20);
+}
+
+// Runs on the CPU thread, the render thread only sees published frames
+static void publish_frame(struct gb_emulator *gb, void *data)
+{
+	struct frame_exchange *exchange = data;
+	struct frame *frame = frame_exchange_back(exchange);
+
+	frame->number = gb->gpu.frames;
+	frame->cycles = gb->cpu.cycles;
+	frame->lcdc = gb->memory.ram[LCDC_LCD];
+	memcpy(frame->pixels, gb->gpu.frame_buffer, sizeof(frame->pixels));
+	memcpy(frame->vram, gb->memory.ram + 0x8000, sizeof(frame->vram));
+	frame_exchange_publish(exchange);
 }
 
 static void *run_emulator_gpu_thread(void *arg)
 {
 	struct gb_context *ctx = arg;
+	struct gb_screen *screen;
+	int scale = ctx->gb->gpu.scale;
+	u8 keys = 0;
 
-	ctx->gb->gpu.renderer.draw = draw;
-
-	render_init(ctx->gb->gpu.width, ctx->gb->gpu.height,
-		    ctx->gb->gpu.scale);
+	render_init(ctx->gb->gpu.width, ctx->gb->gpu.height, scale);
+	screen = calloc(1, sizeof(struct gb_screen));
+	if (!screen || screen_init(screen)) {
+		gb_log_error(ctx, "failed to allocate screen");
+		GB_FLAG_DISABLE(GB_ON);
+	}
 	while (render_is_running() && GB_FLAG(GB_ON)) {
-		render_handle_inputs(&ctx->gb->keys);
+		render_handle_inputs(&keys);
+		mgb_set_input(ctx->gb, keys);
+		ctx->rewinding = render_rewind_requested();
+		screen_update(screen, ctx->exchange);
 		render_begin();
 		ClearBackground(BLACK);
-		ppu_draw(&ctx->gb->gpu);
-		draw_debug_gui(&ctx->gb->gpu, ctx);
+		screen_draw(screen, scale);
+		draw_debug_gui(ctx, screen, scale);
 		render_end();
 	}
+	if (screen)
+		screen_release(screen);
+	zfree(screen);
 	render_release();
 	pthread_exit(NULL);
 }
 
+// Keeps rewind_seconds of frames, the arena is sized for deltas averaging
+// a quarter of a state
+static void init_rewind(struct gb_context *ctx)
+{
+	struct gb_emulator *gb = ctx->gb;
+	u32 frames = ctx->rewind_seconds * REWIND_FRAMES_PER_SECOND;
+	size_t arena_size = frames * mgb_state_size(gb) / 4;
+
+	// Going back would desynchronize the movie frames
+	if (!frames || ctx->movie)
+		return;
+	ctx->rewind = malloc(sizeof(struct rewind));
+	if (!ctx->rewind || rewind_init(ctx->rewind, gb, frames, arena_size)) {
+		gb_log_error(ctx, "failed to allocate rewind buffer");
+		zfree(ctx->rewind);
+		return;
+	}
+	gb->rewind = ctx->rewind;
+}
+
+static void init_movie(struct gb_context *ctx)
+{
+	int err;
+
+	if (!ctx->movie_path)
+		return;
+	ctx->movie = malloc(sizeof(struct movie));
+	if (!ctx->movie) {
+		gb_log_error(ctx, "failed to allocate movie");
+		return;
+	}
+	if (ctx->movie_mode == MOVIE_RECORD)
+		err = movie_record(ctx->movie, ctx->gb, ctx->movie_path);
+	else
+		err = movie_replay(ctx->movie, ctx->gb, ctx->movie_path);
+	if (err) {
+		gb_log_error(ctx, "failed to open movie");
+		zfree(ctx->movie);
+		return;
+	}
+	ctx->gb->movie = ctx->movie;
+}
+
+static void release_movie(struct gb_context *ctx)
+{
+	struct movie *movie = ctx->movie;
+
+	if (!movie)
+		return;
+	if (movie->mode == MOVIE_REPLAY && movie->diverged >= 0) {
+		printf("Movie diverged at frame %ld\n", movie->diverged);
+		ctx->exit_code = -1;
+	} else if (movie->mode == MOVIE_REPLAY) {
+		printf("Movie verified %u checkpoints over %u frames\n",
+		       movie->verified, movie->frame);
+	}
+	if (movie_close(movie))
+		gb_log_error(ctx, "failed to write movie");
+	zfree(ctx->movie);
+}
+
 void gb_stop_emulator(struct gb_context *ctx)
 {
+#ifdef MGB_PROFILE
+	if (ctx->gb)
+		profile_print(&ctx->gb->profile, stdout);
+#endif
+	release_movie(ctx);
+	if (ctx->rewind)
+		rewind_release(ctx->rewind);
+	zfree(ctx->rewind);
 	destroy_gb_emulator(ctx->gb);
+	zfree(ctx->exchange);
 }
 
 int gb_start_emulator(struct gb_context *ctx)
 {
 	pthread_t thread_cpu;
 	pthread_t thread_gpu;
+	pthread_t thread_signal;
+	sigset_t set;
 
+	// Threads created from here inherit the blocked SIGINT
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+	pthread_create(&thread_signal, NULL, run_signal_thread, ctx);
 	if (!(ctx->gb = init_gb_emulator()))
 		gb_log_error(ctx, "failed to initialize emulator");
-	if (load_rom(&ctx->gb->memory, ctx->rom_path))
+	if (gb_load_rom(ctx->gb, ctx->rom_path))
 		gb_log_error(ctx, "failed to load ROM into emulator");
-	pthread_create(&thread_cpu, NULL, run_emulator_cpu_thread, ctx);
 	if (GB_FLAG(GB_DMA)) {
 		ctx->gb->cpu.dma_enabled = true;
 	}
+	if (!ctx->exit_code) {
+		init_movie(ctx);
+		init_rewind(ctx);
+	}
+	if (GB_FLAG(GB_VIDEO)) {
+		ctx->exchange = malloc(sizeof(struct frame_exchange));
+		if (ctx->exchange) {
+			frame_exchange_init(ctx->exchange);
+			ctx->gb->vblank = publish_frame;
+			ctx->gb->vblank_data = ctx->exchange;
+		} else {
+			gb_log_error(ctx, "failed to allocate frame exchange");
+			GB_FLAG_DISABLE(GB_VIDEO);
+		}
+	}
+	pacing_init(&ctx->pacing, ctx->speed);
+	pthread_create(&thread_cpu, NULL, run_emulator_cpu_thread, ctx);
 	if (GB_FLAG(GB_VIDEO)) {
 		ctx->gb->gpu.scale = ctx->scale;
 		printf("Resolution: %dx%d Scale: %d\n", ctx->gb->gpu.width,
@@ -237,17 +376,24 @@ int gb_start_emulator(struct gb_context *ctx)
 		pthread_join(thread_gpu, NULL);
 	}
 	pthread_join(thread_cpu, NULL);
+	pthread_cancel(thread_signal);
+	pthread_join(thread_signal, NULL);
 	return ctx->exit_code;
 }
 
 // clang-format off
-struct gb_option options[] = {
+static const struct gb_option options[] = {
 	{ "-d/--debug         Enable debugger", "--debug", "-d", 0, GB_OPTION_DEBUG },
 	{ "-r/--rom <path>    Path of the ROM", "--rom", "-r", 1, GB_OPTION_ROM },
 	{ "-n/--no-video      Disable video rendering", "--no-video", "-n", 0, GB_OPTION_NO_VIDEO },
 	{ "-D/--no-dma        Disable DMA transfer", "--no-dma", "-D", 0, GB_OPTION_NO_DMA },
 	{ "-s/--scale <int>   Scale viewport", "--scale", "-s", 1, GB_OPTION_SCALE },
-	{ "-t/--throttling    Enable throttling", "--throttling", "-t", 0, GB_OPTION_THROTTLING },
+	{ "-t/--throttling    Run at the hardware speed, the default", "--throttling", "-t", 0, GB_OPTION_THROTTLING },
+	{ "-x/--speed <float> Speed multiplier, 0 runs uncapped", "--speed", "-x", 1, GB_OPTION_SPEED },
+	{ "-f/--fast          Execute whole instructions per step", "--fast", "-f", 0, GB_OPTION_FAST },
+	{ "-w/--rewind <int>  Seconds of rewind history, 0 disables", "--rewind", "-w", 1, GB_OPTION_REWIND },
+	{ "-m/--record <path> Record the inputs to a movie", "--record", "-m", 1, GB_OPTION_RECORD },
+	{ "-p/--replay <path> Replay and verify a movie", "--replay", "-p", 1, GB_OPTION_REPLAY },
 };
 // clang-format on
 
@@ -263,7 +409,15 @@ static void gb_context_init(struct gb_context *ctx)
 	ctx->flags = 0;
 	ctx->rom_path = NULL;
 	ctx->scale = 1;
-	ctx->cycles = 0;
+	ctx->speed = 1;
+	ctx->exchange = NULL;
+	ctx->rewind = NULL;
+	ctx->movie = NULL;
+	ctx->movie_path = NULL;
+	ctx->rewind_seconds = GB_REWIND_SECONDS;
+	ctx->rewinding = 0;
+	ctx->exit_code = 0;
+	ctx->interrupted = 0;
 	GB_FLAG_ENABLE(GB_VIDEO);
 	GB_FLAG_ENABLE(GB_DMA);
 	GB_FLAG_ENABLE(GB_ON);
@@ -287,7 +441,14 @@ static void parse_option(struct gb_context *ctx, int i, int argc, char **argv)
 			GB_FLAG_DISABLE(GB_DMA);
 			break;
 		case GB_OPTION_THROTTLING:
-			GB_FLAG_DISABLE(GB_THROTTLING);
+			ctx->speed = 1;
+			break;
+		case GB_OPTION_SPEED:
+			if (i + 1 < argc)
+				ctx->speed = atof(argv[i + 1]);
+			break;
+		case GB_OPTION_FAST:
+			GB_FLAG_ENABLE(GB_FAST);
 			break;
 		case GB_OPTION_ROM:
 			if (i + 1 < argc)
@@ -297,6 +458,18 @@ static void parse_option(struct gb_context *ctx, int i, int argc, char **argv)
 			if (i + 1 < argc)
 				ctx->scale = atoi(argv[i + 1]);
 			break;
+		case GB_OPTION_RECORD:
+		case GB_OPTION_REPLAY:
+			if (i + 1 < argc)
+				ctx->movie_path = argv[i + 1];
+			ctx->movie_mode = options[j].type == GB_OPTION_RECORD ?
+						  MOVIE_RECORD :
+						  MOVIE_REPLAY;
+			break;
+		case GB_OPTION_REWIND:
+			if (i + 1 < argc)
+				ctx->rewind_seconds = atoi(argv[i + 1]);
+			break;
 		}
 		break;
 	}
@@ -309,9 +482,18 @@ static void print_header(struct gb_context *ctx)
 	printf("Video: %s ", GB_FLAG(GB_VIDEO) ? "On" : "Off");
 	printf("DMA: %s ", GB_FLAG(GB_DMA) ? "On" : "Off");
 	printf("\n");
-	printf("Throttling: %s\n", GB_FLAG(GB_THROTTLING) ? "On" : "Off");
+	if (ctx->speed > 0)
+		printf("Speed: %.2fx ", ctx->speed);
+	else
+		printf("Speed: Uncapped ");
+	printf("Fast: %s\n", GB_FLAG(GB_FAST) ? "On" : "Off");
 	printf("Rom: %s\n", ctx->rom_path ? ctx->rom_path : "Not loaded");
 	printf("Scale: %d\n", ctx->scale);
+	printf("Rewind: %ds\n", ctx->rewind_seconds);
+	if (ctx->movie_path)
+		printf("Movie: %s %s\n",
+		       ctx->movie_mode == MOVIE_RECORD ? "Record" : "Replay",
+		       ctx->movie_path);
 }
 
 static int context_create(struct gb_context *ctx, int argc, char **argv)
@@ -323,6 +505,10 @@ static int context_create(struct gb_context *ctx, int argc, char **argv)
 		return -1;
 	if (ctx->scale < 1)
 		return -1;
+	if (ctx->speed < 0)
+		return -1;
+	if (ctx->rewind_seconds < 0)
+		return -1;
 	return 0;
 }
 
@@ -0,0 +1,189 @@
+#include "platform/hash.h"
+#include "platform/mm.h"
+#include "mgb/movie.h"
+#include "mgb/state.h"
+#include <stdlib.h>
+#include <string.h>
+
+static u64 rom_hash(struct gb_emulator *gb)
+{
+	return hash_fnv1a(FNV_OFFSET_BASIS, gb->cartridge.rom,
+			  gb->cartridge.rom_size);
+}
+
+static void checkpoint(struct movie *movie, struct gb_emulator *gb,
+		       struct movie_record *record)
+{
+	mgb_save_state(gb, movie->state, movie->state_size);
+	record->frame_hash = hash_fnv1a(FNV_OFFSET_BASIS, gb->gpu.frame_buffer,
+					sizeof(gb->gpu.frame_buffer));
+	record->state_hash = hash_fnv1a(FNV_OFFSET_BASIS, movie->state,
+					movie->state_size);
+}
+
+static int movie_init(struct movie *movie, struct gb_emulator *gb,
+		      enum movie_mode mode)
+{
+	memset(movie, 0, sizeof(struct movie));
+	movie->mode = mode;
+	movie->interval = MOVIE_CHECKPOINT_FRAMES;
+	movie->diverged = -1;
+	movie->state_size = mgb_state_size(gb);
+	if (!(movie->state = malloc(movie->state_size)))
+		return -1;
+	return 0;
+}
+
+// Record from power on, the emulator must be freshly loaded or reset
+int movie_record(struct movie *movie, struct gb_emulator *gb,
+		 const char *path)
+{
+	struct movie_header header = {
+		.magic = MGB_MOVIE_MAGIC,
+		.version = MGB_MOVIE_VERSION,
+		.state_version = MGB_STATE_VERSION,
+		.interval = MOVIE_CHECKPOINT_FRAMES,
+		.flags = gb->cpu.dma_enabled ? MOVIE_FLAG_DMA : 0,
+		.rom_hash = rom_hash(gb),
+	};
+
+	if (movie_init(movie, gb, MOVIE_RECORD))
+		return -1;
+	if (!(movie->file = fopen(path, "wb")) ||
+	    fwrite(&header, sizeof(header), 1, movie->file) != 1) {
+		movie_close(movie);
+		return -1;
+	}
+	return 0;
+}
+
+static int load_records(struct movie *movie, FILE *file)
+{
+	long start = ftell(file);
+	long end;
+
+	if (fseek(file, 0, SEEK_END) || (end = ftell(file)) < start ||
+	    fseek(file, start, SEEK_SET))
+		return -1;
+	movie->count = (end - start) / sizeof(struct movie_record);
+	if (!movie->count)
+		return 0;
+	movie->records = malloc(movie->count * sizeof(struct movie_record));
+	if (!movie->records)
+		return -1;
+	if (fread(movie->records, sizeof(struct movie_record), movie->count,
+		  file) != movie->count)
+		return -1;
+	return 0;
+}
+
+// Replay on a freshly loaded emulator, the movie must have been
+// recorded from the same ROM
+int movie_replay(struct movie *movie, struct gb_emulator *gb,
+		 const char *path)
+{
+	struct movie_header header;
+	FILE *file;
+	int err = -1;
+
+	if (movie_init(movie, gb, MOVIE_REPLAY))
+		return -1;
+	if (!(file = fopen(path, "rb"))) {
+		movie_close(movie);
+		return -1;
+	}
+	if (fread(&header, sizeof(header), 1, file) == 1 &&
+	    header.magic == MGB_MOVIE_MAGIC &&
+	    header.version == MGB_MOVIE_VERSION &&
+	    header.state_version == MGB_STATE_VERSION && header.interval &&
+	    header.rom_hash == rom_hash(gb))
+		err = load_records(movie, file);
+	fclose(file);
+	if (err) {
+		movie_close(movie);
+		return -1;
+	}
+	movie->interval = header.interval;
+	gb->cpu.dma_enabled = header.flags & MOVIE_FLAG_DMA;
+	return 0;
+}
+
+static u8 record_frame(struct movie *movie, struct gb_emulator *gb,
+		       u32 frame, u8 keys)
+{
+	struct movie_record record = { .frame = frame };
+
+	if (frame % movie->interval == 0) {
+		record.type = MOVIE_CHECKPOINT;
+		checkpoint(movie, gb, &record);
+		fwrite(&record, sizeof(record), 1, movie->file);
+	}
+	if (keys != movie->keys) {
+		memset(&record, 0, sizeof(record));
+		record.frame = frame;
+		record.type = MOVIE_KEYS;
+		record.keys = keys;
+		fwrite(&record, sizeof(record), 1, movie->file);
+		movie->keys = keys;
+	}
+	return keys;
+}
+
+static u8 replay_frame(struct movie *movie, struct gb_emulator *gb, u32 frame)
+{
+	struct movie_record expected;
+
+	while (movie->next < movie->count &&
+	       movie->records[movie->next].frame <= frame) {
+		struct movie_record *record = &movie->records[movie->next++];
+		switch (record->type) {
+		case MOVIE_KEYS:
+			movie->keys = record->keys;
+			break;
+		case MOVIE_CHECKPOINT:
+			checkpoint(movie, gb, &expected);
+			if (expected.frame_hash == record->frame_hash &&
+			    expected.state_hash == record->state_hash)
+				movie->verified++;
+			else if (movie->diverged < 0)
+				movie->diverged = frame;
+			break;
+		case MOVIE_END:
+			movie->ended = true;
+			break;
+		}
+	}
+	if (movie->next == movie->count)
+		movie->ended = true;
+	return movie->keys;
+}
+
+// Called at every VBlank with the keys of the host, returns the keys to
+// latch for the next frame
+u8 movie_update(struct movie *movie, struct gb_emulator *gb, u8 keys)
+{
+	u32 frame = movie->frame++;
+
+	if (movie->mode == MOVIE_RECORD)
+		return record_frame(movie, gb, frame, keys);
+	return replay_frame(movie, gb, frame);
+}
+
+// A recording is only complete once closed
+int movie_close(struct movie *movie)
+{
+	struct movie_record record = { .frame = movie->frame,
+				       .type = MOVIE_END };
+	int err = 0;
+
+	if (movie->file) {
+		if (fwrite(&record, sizeof(record), 1, movie->file) != 1)
+			err = -1;
+		if (fclose(movie->file))
+			err = -1;
+		movie->file = NULL;
+	}
+	zfree(movie->state);
+	zfree(movie->records);
+	return err;
+}
@@ -0,0 +1,84 @@
+#include "mgb/pacing.h"
+#include "mgb/sm83.h"
+#include "mgb/video.h"
+#include <errno.h>
+#include <time.h>
+
+static s64 now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * PACING_NSEC + now.tv_nsec;
+}
+
+static void sleep_until(s64 deadline)
+{
+	struct timespec ts = {
+		.tv_sec = deadline / PACING_NSEC,
+		.tv_nsec = deadline % PACING_NSEC,
+	};
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+	       EINTR)
+		;
+}
+
+void pacing_init(struct pacing *pacing, double speed)
+{
+	pacing->cycles = 0;
+	pacing->deadline = now_ns();
+	pacing->window = pacing->deadline;
+	pacing->window_cycles = 0;
+	atomic_init(&pacing->percent, 0);
+	pacing_set_speed(pacing, speed);
+}
+
+void pacing_set_speed(struct pacing *pacing, double speed)
+{
+	pacing->speed = speed > 0 ? speed : 0;
+	pacing->period = 0;
+	if (pacing->speed)
+		pacing->period = GB_VIDEO_FRAME_PERIOD * PACING_NSEC /
+				 (SM83_FREQ * pacing->speed);
+	pacing->deadline = now_ns();
+}
+
+// Emulated speed over the last second
+static void measure(struct pacing *pacing, s64 now)
+{
+	s64 elapsed = now - pacing->window;
+
+	if (elapsed < PACING_NSEC)
+		return;
+	atomic_store_explicit(&pacing->percent,
+			      pacing->window_cycles * 100.0 * PACING_NSEC /
+					      ((double)SM83_FREQ * elapsed) +
+				      0.5,
+			      memory_order_relaxed);
+	pacing->window = now;
+	pacing->window_cycles = 0;
+}
+
+// Account for cycles just emulated, sleeps once a whole frame is done
+void pacing_update(struct pacing *pacing, u64 cycles)
+{
+	s64 now;
+
+	pacing->cycles += cycles;
+	pacing->window_cycles += cycles;
+	if (pacing->cycles < GB_VIDEO_FRAME_PERIOD)
+		return;
+	pacing->cycles -= GB_VIDEO_FRAME_PERIOD;
+	now = now_ns();
+	measure(pacing, now);
+	if (!pacing->speed)
+		return;
+	pacing->deadline += pacing->period;
+	// Stalled by the host or a debugger prompt, running fast to catch
+	// up would only make the game stutter
+	if (now - pacing->deadline > PACING_MAX_LAG_FRAMES * pacing->period)
+		pacing->deadline = now;
+	else if (pacing->deadline > now)
+		sleep_until(pacing->deadline);
+}
@@ -0,0 +1,154 @@
+#include "mgb/profile.h"
+#include "mgb/sm83.h"
+#include <string.h>
+
+#define PROFILE_TOP_OPCODES 16
+
+static s64 now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+void profile_reset(struct profile *profile)
+{
+	memset(profile, 0, sizeof(struct profile));
+	profile->start_ticks = profile_ticks();
+	profile->start_ns = now_ns();
+	profile->mark = profile->start_ticks;
+}
+
+// Counters add up, the calibration of dst is kept
+void profile_merge(struct profile *dst, const struct profile *src)
+{
+	for (int i = 0; i < PROFILE_ZONES; i++) {
+		dst->ticks[i] += src->ticks[i];
+		dst->entries[i] += src->entries[i];
+	}
+	for (int i = 0; i < PROFILE_OPCODES; i++)
+		dst->opcodes[i] += src->opcodes[i];
+	for (int i = 0; i < REGION_COUNT; i++) {
+		dst->loads[i] += src->loads[i];
+		dst->writes[i] += src->writes[i];
+	}
+	for (int i = 0; i < SKIP_COUNT; i++)
+		dst->skipped[i] += src->skipped[i];
+}
+
+#ifdef MGB_PROFILE
+// clang-format off
+static const char *zone_names[PROFILE_ZONES] = {
+	[PROFILE_CPU]    = "cpu",
+	[PROFILE_MEMORY] = "memory",
+	[PROFILE_TIMER]  = "timer",
+	[PROFILE_PPU]    = "ppu",
+	[PROFILE_RENDER] = "render",
+	[PROFILE_HOST]   = "host",
+};
+
+static const char *region_names[REGION_COUNT] = {
+	[REGION_ROM]      = "rom",
+	[REGION_VRAM]     = "vram",
+	[REGION_SRAM]     = "sram",
+	[REGION_WRAM]     = "wram",
+	[REGION_ECHO]     = "echo",
+	[REGION_OAM]      = "oam",
+	[REGION_UNUSABLE] = "unusable",
+	[REGION_IO]       = "io",
+	[REGION_HRAM]     = "hram",
+	[REGION_IE]       = "ie",
+};
+
+static const char *skip_names[SKIP_COUNT] = {
+	[SKIP_HALT] = "halt",
+	[SKIP_IDLE] = "idle",
+};
+// clang-format on
+
+static void print_zones(const struct profile *profile, FILE *file)
+{
+	double ns_per_tick = 1;
+	s64 elapsed = now_ns() - profile->start_ns;
+	u64 ticks = profile_ticks() - profile->start_ticks;
+	u64 total = 0;
+
+	if (ticks && elapsed > 0)
+		ns_per_tick = (double)elapsed / ticks;
+	for (int i = 0; i < PROFILE_ZONES; i++)
+		total += profile->ticks[i];
+	fprintf(file, "%-10s %12s %7s %14s %10s\n", "zone", "time", "share",
+		"entries", "ns/entry");
+	for (int i = 0; i < PROFILE_ZONES; i++) {
+		double ns = profile->ticks[i] * ns_per_tick;
+		fprintf(file, "%-10s %10.3fms %6.1f%% %14lu %10.1f\n",
+			zone_names[i], ns / 1e6,
+			total ? 100.0 * profile->ticks[i] / total : 0,
+			profile->entries[i],
+			profile->entries[i] ? ns / profile->entries[i] : 0);
+	}
+}
+
+static void print_regions(const struct profile *profile, FILE *file)
+{
+	fprintf(file, "%-10s %14s %14s\n", "region", "reads", "writes");
+	for (int i = 0; i < REGION_COUNT; i++) {
+		if (!profile->loads[i] && !profile->writes[i])
+			continue;
+		fprintf(file, "%-10s %14lu %14lu\n", region_names[i],
+			profile->loads[i], profile->writes[i]);
+	}
+}
+
+static void print_skipped(const struct profile *profile, FILE *file)
+{
+	fprintf(file, "%-10s %14s\n", "skipped", "cycles");
+	for (int i = 0; i < SKIP_COUNT; i++) {
+		fprintf(file, "%-10s %14lu\n", skip_names[i],
+			profile->skipped[i]);
+	}
+}
+
+// Most executed opcodes, 0xCB counts every prefixed instruction
+static void print_opcodes(const struct profile *profile, FILE *file)
+{
+	bool shown[PROFILE_OPCODES] = { false };
+	u64 total = 0;
+
+	for (int i = 0; i < PROFILE_OPCODES; i++)
+		total += profile->opcodes[i];
+	fprintf(file, "%-10s %-6s %14s %7s\n", "opcode", "", "count",
+		"share");
+	for (int n = 0; n < PROFILE_TOP_OPCODES; n++) {
+		int best = -1;
+		for (int i = 0; i < PROFILE_OPCODES; i++) {
+			if (!shown[i] && profile->opcodes[i] &&
+			    (best < 0 ||
+			     profile->opcodes[i] > profile->opcodes[best]))
+				best = i;
+		}
+		if (best < 0)
+			break;
+		shown[best] = true;
+		fprintf(file, "%s%02X       %-6s %14lu %6.1f%%\n",
+			best >= 256 ? "CB " : "   ", best & 0xFF,
+			sm83_mnemonic(&sm83_instructions[best]),
+			profile->opcodes[best],
+			100.0 * profile->opcodes[best] / total);
+	}
+}
+
+void profile_print(const struct profile *profile, FILE *file)
+{
+	print_zones(profile, file);
+	print_regions(profile, file);
+	print_skipped(profile, file);
+	print_opcodes(profile, file);
+}
+#else
+void profile_print(const struct profile *profile, FILE *file)
+{
+	fprintf(file, "Profiler not built in, rebuild with PROFILE=1\n");
+}
+#endif
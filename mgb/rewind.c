@@ -0,0 +1,192 @@
+#include "platform/mm.h"
+#include "mgb/rewind.h"
+#include "mgb/state.h"
+#include <stdlib.h>
+#include <string.h>
+
+// A run of equal bytes shorter than this stays inside the literal run
+#define DELTA_MIN_ZEROS 4
+#define DELTA_MAX_RUN 0xFFFF
+
+static inline void put16(u8 *p, u16 value)
+{
+	p[0] = value & 0xFF;
+	p[1] = value >> 8;
+}
+
+static inline u16 get16(const u8 *p)
+{
+	return p[0] | p[1] << 8;
+}
+
+static size_t equal_run(const u8 *a, const u8 *b, size_t i, size_t size)
+{
+	size_t start = i;
+	u64 x, y;
+
+	while (i + 8 <= size && i - start + 8 <= DELTA_MAX_RUN) {
+		memcpy(&x, a + i, 8);
+		memcpy(&y, b + i, 8);
+		if (x != y)
+			break;
+		i += 8;
+	}
+	while (i < size && i - start < DELTA_MAX_RUN && a[i] == b[i])
+		i++;
+	return i - start;
+}
+
+// Tokens of a little endian count of unchanged bytes, a count of changed
+// bytes, then the XOR of the changed bytes
+size_t rewind_delta_encode(const u8 *a, const u8 *b, size_t size,
+			   u8 *out)
+{
+	u8 *p = out;
+	size_t i = 0;
+
+	while (i < size) {
+		size_t zeros = equal_run(a, b, i, size);
+		size_t start = i += zeros;
+		u8 *token = p;
+
+		p += 4;
+		while (i < size && i - start < DELTA_MAX_RUN) {
+			if (a[i] != b[i]) {
+				*p++ = a[i] ^ b[i];
+				i++;
+				continue;
+			}
+			if (equal_run(a, b, i, size) >= DELTA_MIN_ZEROS)
+				break;
+			*p++ = 0;
+			i++;
+		}
+		put16(token, zeros);
+		put16(token + 2, i - start);
+	}
+	return p - out;
+}
+
+void rewind_delta_apply(u8 *state, const u8 *delta, size_t size)
+{
+	const u8 *end = delta + size;
+
+	while (delta < end) {
+		u16 zeros = get16(delta);
+		u16 literals = get16(delta + 2);
+		delta += 4;
+		state += zeros;
+		for (int i = 0; i < literals; i++)
+			*state++ ^= *delta++;
+	}
+}
+
+size_t rewind_delta_bound(size_t size)
+{
+	return size + 4 * (size / DELTA_MIN_ZEROS + 1);
+}
+
+int rewind_init(struct rewind *rw, struct gb_emulator *gb, u32 frames,
+		size_t arena_size)
+{
+	memset(rw, 0, sizeof(struct rewind));
+	rw->state_size = mgb_state_size(gb);
+	rw->capacity = frames;
+	rw->arena_size = arena_size;
+	rw->current = malloc(rw->state_size);
+	rw->next = malloc(rw->state_size);
+	rw->scratch = malloc(rewind_delta_bound(rw->state_size));
+	rw->arena = malloc(arena_size);
+	rw->entries = calloc(frames, sizeof(struct rewind_entry));
+	if (!rw->current || !rw->next || !rw->scratch || !rw->arena ||
+	    !rw->entries) {
+		rewind_release(rw);
+		return -1;
+	}
+	return 0;
+}
+
+void rewind_release(struct rewind *rw)
+{
+	zfree(rw->current);
+	zfree(rw->next);
+	zfree(rw->scratch);
+	zfree(rw->arena);
+	zfree(rw->entries);
+	memset(rw, 0, sizeof(struct rewind));
+}
+
+static struct rewind_entry *oldest(struct rewind *rw)
+{
+	return &rw->entries[(rw->head + rw->capacity - rw->count) %
+			    rw->capacity];
+}
+
+// Records sit in the arena in the order they were written, the ones
+// right after the write offset are the oldest
+static void store(struct rewind *rw, const u8 *delta, size_t size)
+{
+	struct rewind_entry *entry;
+
+	if (size > rw->arena_size) {
+		rw->count = 0;
+		return;
+	}
+	if (rw->write + size > rw->arena_size) {
+		// Records past the write offset are the oldest ones
+		while (rw->count && oldest(rw)->offset >= rw->write)
+			rw->count--;
+		rw->write = 0;
+	}
+	while (rw->count) {
+		entry = oldest(rw);
+		if (rw->count < rw->capacity &&
+		    (entry->offset >= rw->write + size ||
+		     entry->offset + entry->size <= rw->write))
+			break;
+		rw->count--;
+	}
+	memcpy(rw->arena + rw->write, delta, size);
+	entry = &rw->entries[rw->head];
+	entry->offset = rw->write;
+	entry->size = size;
+	rw->head = (rw->head + 1) % rw->capacity;
+	rw->count++;
+	rw->write += size;
+}
+
+void rewind_push(struct rewind *rw, struct gb_emulator *gb)
+{
+	u8 *state = rw->next;
+
+	rw->pending = false;
+	mgb_save_state(gb, state, rw->state_size);
+	if (rw->valid)
+		store(rw, rw->scratch,
+		      rewind_delta_encode(rw->current, state, rw->state_size,
+					  rw->scratch));
+	rw->next = rw->current;
+	rw->current = state;
+	rw->valid = true;
+}
+
+// Go back up to frames records, returns how many were available
+u32 rewind_step(struct rewind *rw, struct gb_emulator *gb, u32 frames)
+{
+	struct rewind_entry *entry;
+	u32 done = 0;
+
+	if (!rw->valid)
+		return 0;
+	for (; done < frames && rw->count; done++) {
+		rw->head = (rw->head + rw->capacity - 1) % rw->capacity;
+		rw->count--;
+		entry = &rw->entries[rw->head];
+		rewind_delta_apply(rw->current, rw->arena + entry->offset,
+				   entry->size);
+		rw->write = entry->offset;
+	}
+	mgb_load_state(gb, rw->current, rw->state_size);
+	rw->pending = false;
+	return done;
+}
@@ -0,0 +1,101 @@
+#include "mgb/scheduler.h"
+
+static bool entry_before(struct scheduler_entry *a, struct scheduler_entry *b)
+{
+	// Same cycle events are dispatched in enum order
+	if (a->deadline != b->deadline)
+		return a->deadline < b->deadline;
+	return a->event < b->event;
+}
+
+static void entry_place(struct scheduler *sched, int i,
+			struct scheduler_entry entry)
+{
+	sched->heap[i] = entry;
+	sched->position[entry.event] = i;
+}
+
+static void sift_up(struct scheduler *sched, int i)
+{
+	struct scheduler_entry entry = sched->heap[i];
+	while (i > 0) {
+		int parent = (i - 1) / 2;
+		if (!entry_before(&entry, &sched->heap[parent]))
+			break;
+		entry_place(sched, i, sched->heap[parent]);
+		i = parent;
+	}
+	entry_place(sched, i, entry);
+}
+
+static void sift_down(struct scheduler *sched, int i)
+{
+	struct scheduler_entry entry = sched->heap[i];
+	for (;;) {
+		int child = 2 * i + 1;
+		if (child >= sched->size)
+			break;
+		if (child + 1 < sched->size &&
+		    entry_before(&sched->heap[child + 1], &sched->heap[child]))
+			child++;
+		if (!entry_before(&sched->heap[child], &entry))
+			break;
+		entry_place(sched, i, sched->heap[child]);
+		i = child;
+	}
+	entry_place(sched, i, entry);
+}
+
+static void remove_at(struct scheduler *sched, int i)
+{
+	struct scheduler_entry last;
+
+	sched->position[sched->heap[i].event] = -1;
+	if (i == --sched->size)
+		return;
+	last = sched->heap[sched->size];
+	entry_place(sched, i, last);
+	sift_down(sched, i);
+	sift_up(sched, sched->position[last.event]);
+}
+
+void scheduler_init(struct scheduler *sched)
+{
+	sched->size = 0;
+	for (int i = 0; i < EVENT_COUNT; i++)
+		sched->position[i] = -1;
+}
+
+void scheduler_schedule(struct scheduler *sched, enum scheduler_event event,
+			u64 deadline)
+{
+	struct scheduler_entry entry = { deadline, event };
+	int i = sched->position[event];
+
+	if (deadline == SCHEDULER_NEVER) {
+		scheduler_cancel(sched, event);
+		return;
+	}
+	if (i < 0) {
+		i = sched->size++;
+		entry_place(sched, i, entry);
+		sift_up(sched, i);
+		return;
+	}
+	entry_place(sched, i, entry);
+	sift_down(sched, i);
+	sift_up(sched, sched->position[event]);
+}
+
+void scheduler_cancel(struct scheduler *sched, enum scheduler_event event)
+{
+	if (sched->position[event] >= 0)
+		remove_at(sched, sched->position[event]);
+}
+
+enum scheduler_event scheduler_pop(struct scheduler *sched)
+{
+	enum scheduler_event event = sched->heap[0].event;
+	remove_at(sched, 0);
+	return event;
+}
@@ -5,9 +5,9 @@
 static void sm83_stack_push_pc(struct sm83_core *cpu, u16 *pc)
 {
 	cpu->sp--;
-	cpu->memory.write8(cpu, cpu->sp, msb(cpu->pc));
+	sm83_write8(cpu, cpu->sp, msb(cpu->pc));
 	cpu->sp--;
-	cpu->memory.write8(cpu, cpu->sp, lsb(cpu->pc));
+	sm83_write8(cpu, cpu->sp, lsb(cpu->pc));
 }
 
 void sm83_cpu_reset(struct sm83_core *cpu)
@@ -15,15 +15,17 @@ void sm83_cpu_reset(struct sm83_core *cpu)
 	cpu->sp = 0xFFFE;
 	cpu->pc = 0x0100;
 
-	SET_AF(cpu, 0x01B0);
-	SET_BC(cpu, 0x0013);
-	SET_DE(cpu, 0x00D8);
-	SET_HL(cpu, 0x014D);
+	cpu->af = 0x01B0;
+	cpu->bc = 0x0013;
+	cpu->de = 0x00D8;
+	cpu->hl = 0x014D;
 
 	cpu->cycles = 0;
+	cpu->instructions = 0;
 	cpu->halted = false;
 	cpu->ime = false;
 	cpu->ime_cycles = 0;
+	cpu->pending = 0;
 	cpu->ptr = 0;
 	// Memory value of program counter
 	cpu->bus = 0;
@@ -33,12 +35,13 @@ void sm83_cpu_reset(struct sm83_core *cpu)
 	cpu->index = 0;
 	cpu->state = SM83_CORE_FETCH;
 	cpu->previous = SM83_CORE_FETCH;
+	cpu->instruction = sm83_decode(0x00, false);
+	cpu->idle.valid = false;
+	cpu->lazy.op = LAZY_NONE;
 	cpu->multiplier = 1;
 
 	// Timers
-	cpu->timer_enabled = true;
-	cpu->internal_divider = 0;
-	cpu->internal_timer = 0;
+	sm83_timer_reset(cpu);
 	// DMA
 	cpu->dma_enabled = false;
 	cpu->dma.start_address = 0;
@@ -48,15 +51,89 @@ void sm83_cpu_reset(struct sm83_core *cpu)
 
 void sm83_halt(struct sm83_core *cpu)
 {
-	u8 reg_ie = cpu->memory.load8(cpu, IE);
-	u8 reg_if = cpu->memory.load8(cpu, IF);
-	if (!(reg_ie & reg_if & 0x1F)) {
+	if (!cpu->pending) {
 		cpu->state = SM83_CORE_HALT;
 	} else if (!cpu->ime) {
 		cpu->state = SM83_CORE_HALT_BUG;
 	}
 }
 
+// Code is only inspected from directly mapped pages, reading anything
+// else could have side effects
+static bool sm83_peek(struct sm83_core *cpu, u16 addr, u8 *value)
+{
+	u8 *page = cpu->memory.load_pages[addr >> MEMORY_PAGE_SHIFT];
+
+	if (!page)
+		return false;
+	*value = page[addr & (MEMORY_PAGE_SIZE - 1)];
+	return true;
+}
+
+// Only changed by the PPU, from its scheduled events
+static bool sm83_idle_register(u16 addr)
+{
+	return addr == LY_LCD || addr == STAT_LCD;
+}
+
+// Number of instructions of the loop closed by the branch just taken
+// from index back to pc, when the loop only reads LY or STAT into A and
+// tests it. An iteration then leaves A and F as the only changes and
+// repeats until the PPU updates the register. Returns 0 otherwise.
+u32 sm83_idle_loop(struct sm83_core *cpu)
+{
+	const struct sm83_instruction *branch = cpu->instruction;
+	u16 addr = cpu->pc;
+	u32 count = 1;
+	u8 op, lo, hi;
+
+	if (branch->prefixed || cpu->index - cpu->pc > SM83_IDLE_LOOP_SIZE)
+		return 0;
+	switch (branch->opcode) {
+	case 0x18: // JR e
+	case 0x20: // JR NZ,e
+	case 0x28: // JR Z,e
+	case 0x30: // JR NC,e
+	case 0x38: // JR C,e
+	case 0xC2: // JP NZ,nn
+	case 0xC3: // JP nn
+	case 0xCA: // JP Z,nn
+	case 0xD2: // JP NC,nn
+	case 0xDA: // JP C,nn
+		break;
+	default:
+		return 0;
+	}
+	for (; addr < cpu->index; addr += sm83_instructions[op].length) {
+		if (!sm83_peek(cpu, addr, &op) || !sm83_peek(cpu, addr + 1, &lo))
+			return 0;
+		switch (op) {
+		case 0xF0: // LDH A,(n)
+			if (!sm83_idle_register(0xFF00 | lo))
+				return 0;
+			break;
+		case 0xFA: // LD A,(nn)
+			if (!sm83_peek(cpu, addr + 2, &hi) ||
+			    !sm83_idle_register(unsigned_16(lo, hi)))
+				return 0;
+			break;
+		case 0xCB: // BIT b,A
+			if ((lo & 0xC7) != 0x47)
+				return 0;
+			break;
+		case 0xA7: // AND A
+		case 0xB7: // OR A
+		case 0xE6: // AND n
+		case 0xFE: // CP n
+			break;
+		default:
+			return 0;
+		}
+		count++;
+	}
+	return addr == cpu->index ? count : 0;
+}
+
 void sm83_schedule_dma_transfer(struct sm83_core *cpu, u16 start_address)
 {
 	if (!cpu->dma.scheduled) {
@@ -89,10 +166,9 @@ void sm83_cpu_step(struct sm83_core *cpu)
 			//        cpu->dma.start_addr + cpu->dma.cursor,
 			//        cpu->dma.scheduled);
 			--cpu->dma.remaining;
-			u8 value = cpu->memory.load8(
+			u8 value = sm83_load8(
 				cpu, cpu->dma.start_address + cpu->dma.remaining);
-			cpu->memory.write8(cpu, 0xFE00 + cpu->dma.remaining,
-					   value);
+			sm83_write8(cpu, 0xFE00 + cpu->dma.remaining, value);
 		} else {
 			cpu->dma.scheduled = false;
 			cpu->pc++;
@@ -102,31 +178,33 @@ void sm83_cpu_step(struct sm83_core *cpu)
 		break;
 	}
 	case SM83_CORE_FETCH:
-		irq_ack = sm83_irq_ack(cpu);
-		if (irq_ack) {
+		if (cpu->pending && cpu->ime) {
+			irq_ack = sm83_irq_ack(cpu);
 			cpu->ime = false;
 			sm83_stack_push_pc(cpu, &cpu->pc);
 			cpu->pc = irq_ack;
 		}
-		cpu->bus = cpu->memory.load8(cpu, cpu->pc);
-		cpu->instruction = sm83_decode(cpu);
+		cpu->bus = sm83_load8(cpu, cpu->pc);
+		cpu->instruction = sm83_decode(cpu->bus, false);
+		PROFILE_OPCODE(cpu->profile, cpu->bus);
 		cpu->index = cpu->pc;
 		++cpu->pc;
+		++cpu->instructions;
 		sm83_isa_execute(cpu);
 		break;
 	case SM83_CORE_PC:
-		cpu->bus = cpu->memory.load8(cpu, cpu->pc);
+		cpu->bus = sm83_load8(cpu, cpu->pc);
 		++cpu->pc;
 		sm83_isa_execute(cpu);
 		break;
 	case SM83_CORE_READ_0:
 	case SM83_CORE_READ_1:
-		cpu->bus = cpu->memory.load8(cpu, cpu->ptr);
+		cpu->bus = sm83_load8(cpu, cpu->ptr);
 		sm83_isa_execute(cpu);
 		break;
 	case SM83_CORE_WRITE_0:
 	case SM83_CORE_WRITE_1:
-		cpu->memory.write8(cpu, cpu->ptr, cpu->bus);
+		sm83_write8(cpu, cpu->ptr, cpu->bus);
 		sm83_isa_execute(cpu);
 		break;
 	case SM83_CORE_IDLE_0:
@@ -143,36 +221,60 @@ void sm83_cpu_step(struct sm83_core *cpu)
 				sm83_stack_push_pc(cpu, &cpu->pc);
 				cpu->pc = irq_ack;
 			}
-		} else {
-			u8 reg_ie = cpu->memory.load8(cpu, IE);
-			u8 reg_if = cpu->memory.load8(cpu, IF);
-			if ((reg_ie & reg_if & 0x1F)) {
-				cpu->memory.write8(cpu, IF, 0);
-				cpu->halted = false;
-				cpu->state = SM83_CORE_FETCH;
-				cpu->pc++;
-			}
+		} else if (cpu->pending) {
+			*sm83_io(cpu, IF) = 0;
+			sm83_irq_refresh(cpu);
+			cpu->halted = false;
+			cpu->state = SM83_CORE_FETCH;
+			cpu->pc++;
 		}
 		break;
 	}
 	case SM83_CORE_HALT_BUG: {
 		// FIX ME
-		u8 irq_regs;
-		u8 irq_reqs;
 		// printf("Halt bug is triggered\n");
-		irq_reqs = cpu->memory.load8(cpu, IF);
-		irq_regs = cpu->memory.load8(cpu, IE) & irq_reqs;
-		if (irq_regs != 0) {
+		if (cpu->pending) {
 			cpu->index = cpu->sp;
 			cpu->ime = false;
 			cpu->state = SM83_CORE_FETCH;
-			cpu->memory.write8(cpu, IF, 0);
+			*sm83_io(cpu, IF) = 0;
+			sm83_irq_refresh(cpu);
 		}
 		cpu->state = SM83_CORE_FETCH;
 		cpu->halted = false;
 		break;
 	}
 	}
-	if (cpu->timer_enabled)
-		sm83_update_timer_registers(cpu);
+}
+
+static bool sm83_io_access(struct sm83_core *cpu)
+{
+	switch (cpu->state) {
+	case SM83_CORE_READ_0:
+	case SM83_CORE_READ_1:
+	case SM83_CORE_WRITE_0:
+	case SM83_CORE_WRITE_1:
+		return (cpu->ptr >= 0xFF00 && cpu->ptr < 0xFF80) ||
+		       cpu->ptr == IE;
+	default:
+		return false;
+	}
+}
+
+u32 sm83_cpu_run_instruction(struct sm83_core *cpu)
+{
+	u64 start = cpu->cycles;
+
+	// Run M-cycles until the core is back to fetching, a halted core
+	// only consumes a single cycle per call. Devices behind memory.sync
+	// only catch up when the instruction is about to access an I/O
+	// register.
+	do {
+		if (cpu->memory.sync && sm83_io_access(cpu))
+			cpu->memory.sync(cpu);
+		sm83_cpu_step(cpu);
+	} while (cpu->state != SM83_CORE_FETCH &&
+		 cpu->state != SM83_CORE_HALT &&
+		 cpu->state != SM83_CORE_HALT_BUG);
+	return cpu->cycles - start;
 }
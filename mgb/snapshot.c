@@ -0,0 +1,307 @@
+#include "platform/mm.h"
+#include "mgb/snapshot.h"
+#include "mgb/state.h"
+#include <stdlib.h>
+#include <string.h>
+
+static inline bool test_bit(const u64 *bits, int i)
+{
+	return bits[i / 64] & (1ULL << (i % 64));
+}
+
+static inline void set_bit(u64 *bits, int i)
+{
+	bits[i / 64] |= 1ULL << (i % 64);
+}
+
+// Tracked page index of a page, pages of memory.ram come first
+static int dirty_index(struct gb_emulator *gb, u8 *page)
+{
+	if (page >= gb->memory.ram && page < gb->memory.ram + MEMORY_SIZE)
+		return (page - gb->memory.ram) >> MEMORY_PAGE_SHIFT;
+	return MEMORY_PAGE_COUNT +
+	       ((page - gb->cartridge.ram) >> MEMORY_PAGE_SHIFT);
+}
+
+// Pages a snapshot without parent holds: VRAM, 0xC000-0xFFFF and the
+// whole cartridge RAM
+static void tracked_pages(struct gb_emulator *gb, u64 *bits)
+{
+	int ram_pages = gb->cartridge.ram_size >> MEMORY_PAGE_SHIFT;
+
+	memset(bits, 0, DIRTY_WORDS * sizeof(u64));
+	bits[0x80 / 64] = 0xFFFFFFFFULL;
+	bits[0xC0 / 64] = ~0ULL;
+	for (int i = 0; i < ram_pages; i++)
+		set_bit(bits, MEMORY_PAGE_COUNT + i);
+}
+
+// Withhold every writable page from the CPU, dirty bits must be clear
+static void dirty_protect(struct gb_emulator *gb)
+{
+	struct sm83_memory *memory = &gb->cpu.memory;
+
+	for (int i = 0; i < MEMORY_PAGE_COUNT; i++) {
+		if (!memory->write_pages[i])
+			continue;
+		gb->dirty.pages[i] = memory->write_pages[i];
+		memory->write_pages[i] = NULL;
+	}
+}
+
+// Only GB_HEIGHT lines exist, the rest of the last word stays clear
+static void mask_lines(u64 *lines)
+{
+	for (int i = GB_HEIGHT; i < DIRTY_LINE_WORDS * 64; i++)
+		lines[i / 64] &= ~(1ULL << (i % 64));
+}
+
+// First write to a withheld page
+bool gb_dirty_fault(struct gb_emulator *gb, u16 addr, u8 value)
+{
+	u8 *page = gb->dirty.pages[addr >> MEMORY_PAGE_SHIFT];
+
+	if (!page)
+		return false;
+	set_bit(gb->dirty.bits, dirty_index(gb, page));
+	gb->cpu.memory.write_pages[addr >> MEMORY_PAGE_SHIFT] = page;
+	gb->dirty.pages[addr >> MEMORY_PAGE_SHIFT] = NULL;
+	page[addr & (MEMORY_PAGE_SIZE - 1)] = value;
+	return true;
+}
+
+// The cartridge switched RAM banks, clean pages of the new bank are
+// withheld again
+void gb_dirty_remap(struct gb_emulator *gb)
+{
+	struct sm83_memory *memory = &gb->cpu.memory;
+	int start = CARTRIDGE_RAM_START >> MEMORY_PAGE_SHIFT;
+	int end = start + (CARTRIDGE_RAM_BANK_SIZE >> MEMORY_PAGE_SHIFT);
+
+	if (!gb->dirty.enabled)
+		return;
+	for (int i = start; i < end; i++) {
+		u8 *page = memory->write_pages[i];
+		gb->dirty.pages[i] = NULL;
+		if (!page || test_bit(gb->dirty.bits, dirty_index(gb, page)))
+			continue;
+		gb->dirty.pages[i] = page;
+		memory->write_pages[i] = NULL;
+	}
+}
+
+// Memory was changed behind the page table, everything is dirty until
+// the next snapshot
+void gb_dirty_reset(struct gb_emulator *gb)
+{
+	struct sm83_memory *memory = &gb->cpu.memory;
+
+	for (int i = 0; i < MEMORY_PAGE_COUNT; i++) {
+		if (!gb->dirty.pages[i])
+			continue;
+		memory->write_pages[i] = gb->dirty.pages[i];
+		gb->dirty.pages[i] = NULL;
+	}
+	memset(gb->dirty.bits, 0xFF, sizeof(gb->dirty.bits));
+	memset(gb->gpu.dirty_lines, 0xFF, sizeof(gb->gpu.dirty_lines));
+}
+
+static int count_bits(const u64 *bits, int words)
+{
+	int count = 0;
+	for (int i = 0; i < words; i++)
+		count += __builtin_popcountll(bits[i]);
+	return count;
+}
+
+// Copy the selected chunks from or to data, which holds the stored
+// chunks in bitmap order
+static void copy_chunks(u8 *base, u8 *data, const u64 *stored,
+			const u64 *selected, int words, int size, bool save)
+{
+	for (int w = 0; w < words; w++) {
+		u64 todo = selected[w];
+		while (todo) {
+			int bit = __builtin_ctzll(todo);
+			int rank = __builtin_popcountll(stored[w] &
+							((1ULL << bit) - 1));
+			u8 *chunk = base + (size_t)(w * 64 + bit) * size;
+			if (save)
+				memcpy(data + rank * size, chunk, size);
+			else
+				memcpy(chunk, data + rank * size, size);
+			todo &= todo - 1;
+		}
+		data += __builtin_popcountll(stored[w]) * size;
+	}
+}
+
+static struct gb_snapshot *snapshot_alloc(const u64 *pages, const u64 *lines)
+{
+	struct gb_snapshot *snapshot;
+	size_t size = sizeof(struct gb_snapshot) + sizeof(struct gb_state_core) +
+		      count_bits(pages, DIRTY_WORDS) * MEMORY_PAGE_SIZE +
+		      count_bits(lines, DIRTY_LINE_WORDS) * GB_WIDTH;
+
+	if (!(snapshot = malloc(size)))
+		return NULL;
+	snapshot->core = (struct gb_state_core *)(snapshot + 1);
+	snapshot->data = (u8 *)(snapshot->core + 1);
+	memcpy(snapshot->pages, pages, sizeof(snapshot->pages));
+	memcpy(snapshot->lines, lines, sizeof(snapshot->lines));
+	snapshot->refs = 1;
+	snapshot->depth = 0;
+	snapshot->parent = NULL;
+	return snapshot;
+}
+
+// Memory pages go first in data, then the frame buffer lines
+static u8 *snapshot_lines(struct gb_snapshot *snapshot)
+{
+	return snapshot->data +
+	       count_bits(snapshot->pages, DIRTY_WORDS) * MEMORY_PAGE_SIZE;
+}
+
+// Pages may live in memory.ram or in the cartridge RAM
+static void copy_pages(struct gb_emulator *gb, struct gb_snapshot *snapshot,
+		       const u64 *selected, bool save)
+{
+	int words = MEMORY_PAGE_COUNT / 64;
+	u8 *data = snapshot->data;
+
+	copy_chunks(gb->memory.ram, data, snapshot->pages, selected, words,
+		    MEMORY_PAGE_SIZE, save);
+	data += count_bits(snapshot->pages, words) * MEMORY_PAGE_SIZE;
+	copy_chunks(gb->cartridge.ram, data, snapshot->pages + words,
+		    selected + words, DIRTY_WORDS - words, MEMORY_PAGE_SIZE,
+		    save);
+}
+
+static void set_base(struct gb_emulator *gb, struct gb_snapshot *snapshot)
+{
+	snapshot->refs++;
+	if (gb->snapshot)
+		gb_snapshot_release(gb->snapshot);
+	gb->snapshot = snapshot;
+	memset(gb->dirty.bits, 0, sizeof(gb->dirty.bits));
+	memset(gb->gpu.dirty_lines, 0, sizeof(gb->gpu.dirty_lines));
+	gb->dirty.enabled = true;
+	dirty_protect(gb);
+}
+
+// Snapshot of the machine, incremental against the last snapshot taken
+// or restored on this instance. The caller owns a reference.
+struct gb_snapshot *gb_snapshot_take(struct gb_emulator *gb)
+{
+	struct gb_snapshot *parent = gb->dirty.enabled ? gb->snapshot : NULL;
+	struct gb_snapshot *snapshot;
+	u64 pages[DIRTY_WORDS];
+	u64 lines[DIRTY_LINE_WORDS];
+
+	if (parent && parent->depth >= SNAPSHOT_MAX_DEPTH)
+		parent = NULL;
+	tracked_pages(gb, pages);
+	memset(lines, 0xFF, sizeof(lines));
+	if (parent) {
+		// The hardware registers page is written behind the page table
+		set_bit(gb->dirty.bits, P1_JOYP >> MEMORY_PAGE_SHIFT);
+		for (int i = 0; i < DIRTY_WORDS; i++)
+			pages[i] &= gb->dirty.bits[i];
+		memcpy(lines, gb->gpu.dirty_lines, sizeof(lines));
+	}
+	mask_lines(lines);
+	if (!(snapshot = snapshot_alloc(pages, lines)))
+		return NULL;
+	gb_state_save_core(gb, snapshot->core);
+	copy_pages(gb, snapshot, pages, true);
+	copy_chunks(gb->gpu.frame_buffer, snapshot_lines(snapshot), lines,
+		    lines, DIRTY_LINE_WORDS, GB_WIDTH, true);
+	if (parent) {
+		snapshot->parent = parent;
+		snapshot->depth = parent->depth + 1;
+		parent->refs++;
+	}
+	set_base(gb, snapshot);
+	return snapshot;
+}
+
+// Pages that may differ between the machine and a snapshot: the ones
+// dirty since the base and the ones stored on the way from the base and
+// the snapshot to their common ancestor. Everything without one.
+static void restore_set(struct gb_emulator *gb, struct gb_snapshot *snapshot,
+			u64 *pages, u64 *lines)
+{
+	struct gb_snapshot *a = gb->dirty.enabled ? gb->snapshot : NULL;
+	struct gb_snapshot *b = snapshot;
+
+	memcpy(pages, gb->dirty.bits, sizeof(gb->dirty.bits));
+	memcpy(lines, gb->gpu.dirty_lines, sizeof(gb->gpu.dirty_lines));
+	set_bit(pages, P1_JOYP >> MEMORY_PAGE_SHIFT);
+	while (a != b) {
+		struct gb_snapshot *s;
+		if (!a || !b) {
+			memset(pages, 0xFF, DIRTY_WORDS * sizeof(u64));
+			memset(lines, 0xFF, DIRTY_LINE_WORDS * sizeof(u64));
+			return;
+		}
+		s = a->depth >= b->depth ? a : b;
+		for (int i = 0; i < DIRTY_WORDS; i++)
+			pages[i] |= s->pages[i];
+		for (int i = 0; i < DIRTY_LINE_WORDS; i++)
+			lines[i] |= s->lines[i];
+		if (s == a)
+			a = a->parent;
+		else
+			b = b->parent;
+	}
+}
+
+// Each page and line is copied once, from the closest snapshot holding it
+int gb_snapshot_restore(struct gb_emulator *gb, struct gb_snapshot *snapshot)
+{
+	u64 pages[DIRTY_WORDS];
+	u64 lines[DIRTY_LINE_WORDS];
+	u64 tracked[DIRTY_WORDS];
+	u64 left;
+
+	restore_set(gb, snapshot, pages, lines);
+	mask_lines(lines);
+	tracked_pages(gb, tracked);
+	for (int i = 0; i < DIRTY_WORDS; i++)
+		pages[i] &= tracked[i];
+	for (struct gb_snapshot *s = snapshot; s; s = s->parent) {
+		u64 todo[DIRTY_WORDS];
+		u64 todo_lines[DIRTY_LINE_WORDS];
+		left = 0;
+		for (int i = 0; i < DIRTY_WORDS; i++) {
+			todo[i] = pages[i] & s->pages[i];
+			pages[i] &= ~todo[i];
+			left |= pages[i];
+		}
+		for (int i = 0; i < DIRTY_LINE_WORDS; i++) {
+			todo_lines[i] = lines[i] & s->lines[i];
+			lines[i] &= ~todo_lines[i];
+			left |= lines[i];
+		}
+		copy_pages(gb, s, todo, false);
+		copy_chunks(gb->gpu.frame_buffer, snapshot_lines(s), s->lines,
+			    todo_lines, DIRTY_LINE_WORDS, GB_WIDTH, false);
+		if (!left)
+			break;
+	}
+	gb_state_load_core(gb, snapshot->core);
+	gb_dirty_reset(gb);
+	cartridge_map(&gb->cartridge, &gb->cpu.memory, true);
+	sm83_irq_refresh(&gb->cpu);
+	set_base(gb, snapshot);
+	return 0;
+}
+
+void gb_snapshot_release(struct gb_snapshot *snapshot)
+{
+	while (snapshot && !--snapshot->refs) {
+		struct gb_snapshot *parent = snapshot->parent;
+		zfree(snapshot);
+		snapshot = parent;
+	}
+}
@@ -0,0 +1,220 @@
+#include "platform/mm.h"
+#include "mgb/state.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void save_cpu(struct sm83_core *cpu, struct gb_state_cpu *state)
+{
+	state->cycles = cpu->cycles;
+	state->instructions = cpu->instructions;
+	state->ime_cycles = cpu->ime_cycles;
+	state->timer = cpu->timer;
+	state->dma = cpu->dma;
+	state->pc = cpu->pc;
+	state->sp = cpu->sp;
+	state->index = cpu->index;
+	state->ptr = cpu->ptr;
+	state->acc = cpu->acc;
+	state->instruction = cpu->instruction - sm83_instructions;
+	state->a = cpu->a;
+	state->f = sm83_flags(cpu);
+	state->b = cpu->b;
+	state->c = cpu->c;
+	state->d = cpu->d;
+	state->e = cpu->e;
+	state->h = cpu->h;
+	state->l = cpu->l;
+	state->bus = cpu->bus;
+	state->ime = cpu->ime;
+	state->halted = cpu->halted;
+	state->dma_enabled = cpu->dma_enabled;
+	state->state = cpu->state;
+	state->previous = cpu->previous;
+	state->multiplier = cpu->multiplier;
+}
+
+static void load_cpu(struct sm83_core *cpu, const struct gb_state_cpu *state)
+{
+	cpu->cycles = state->cycles;
+	cpu->instructions = state->instructions;
+	cpu->ime_cycles = state->ime_cycles;
+	cpu->timer = state->timer;
+	cpu->dma = state->dma;
+	cpu->pc = state->pc;
+	cpu->sp = state->sp;
+	cpu->index = state->index;
+	cpu->ptr = state->ptr;
+	cpu->acc = state->acc;
+	cpu->instruction = &sm83_instructions[state->instruction & 0x1FF];
+	cpu->idle.valid = false;
+	cpu->a = state->a;
+	cpu_flag_set(cpu, state->f);
+	cpu->b = state->b;
+	cpu->c = state->c;
+	cpu->d = state->d;
+	cpu->e = state->e;
+	cpu->h = state->h;
+	cpu->l = state->l;
+	cpu->bus = state->bus;
+	cpu->ime = state->ime;
+	cpu->halted = state->halted;
+	cpu->dma_enabled = state->dma_enabled;
+	cpu->state = state->state;
+	cpu->previous = state->previous;
+	cpu->multiplier = state->multiplier;
+}
+
+static void save_ppu(struct ppu *gpu, struct gb_state_ppu *state)
+{
+	state->frames = gpu->frames;
+	state->dots = gpu->dots;
+	state->cycles = gpu->cycles;
+	state->x = gpu->x;
+	state->ly = gpu->ly;
+	state->mode = gpu->mode;
+	state->window_line = gpu->window_line;
+}
+
+static void load_ppu(struct ppu *gpu, const struct gb_state_ppu *state)
+{
+	gpu->frames = state->frames;
+	gpu->dots = state->dots;
+	gpu->cycles = state->cycles;
+	gpu->x = state->x;
+	gpu->ly = state->ly;
+	gpu->mode = state->mode;
+	gpu->window_line = state->window_line;
+}
+
+// Heap entries are moved through temporaries, field by field keeps
+// their padding out of the state
+static void save_scheduler(struct scheduler *sched, struct scheduler *state)
+{
+	for (int i = 0; i < EVENT_COUNT; i++) {
+		state->heap[i].deadline = sched->heap[i].deadline;
+		state->heap[i].event = sched->heap[i].event;
+		state->position[i] = sched->position[i];
+	}
+	state->size = sched->size;
+}
+
+void gb_state_save_core(struct gb_emulator *gb, struct gb_state_core *core)
+{
+	save_cpu(&gb->cpu, &core->cpu);
+	save_ppu(&gb->gpu, &core->gpu);
+	save_scheduler(&gb->scheduler, &core->scheduler);
+	core->cartridge = gb->cartridge.regs;
+	core->keys = gb->keys;
+}
+
+// The caller remaps the cartridge banks once the memory is restored
+void gb_state_load_core(struct gb_emulator *gb,
+			const struct gb_state_core *core)
+{
+	load_cpu(&gb->cpu, &core->cpu);
+	load_ppu(&gb->gpu, &core->gpu);
+	gb->scheduler = core->scheduler;
+	gb->cartridge.regs = core->cartridge;
+	gb->keys = core->keys;
+}
+
+size_t mgb_state_size(struct gb_emulator *gb)
+{
+	return sizeof(struct gb_state) + gb->cartridge.ram_size;
+}
+
+// Serialize the machine into buffer, returns the number of bytes written
+// or 0 when the buffer is too small
+size_t mgb_save_state(struct gb_emulator *gb, void *buffer, size_t size)
+{
+	struct gb_state *state = buffer;
+	size_t total = mgb_state_size(gb);
+
+	if (size < total)
+		return 0;
+	// Padding is cleared so equal machines give equal bytes
+	memset(state, 0, offsetof(struct gb_state, frame_buffer));
+	state->header.magic = MGB_STATE_MAGIC;
+	state->header.version = MGB_STATE_VERSION;
+	state->header.type = gb->cartridge.type;
+	state->header.size = total;
+	state->header.ram_size = gb->cartridge.ram_size;
+	gb_state_save_core(gb, &state->core);
+	memcpy(state->frame_buffer, gb->gpu.frame_buffer,
+	       sizeof(state->frame_buffer));
+	memcpy(state->vram, gb->memory.ram + MGB_STATE_VRAM_START,
+	       MGB_STATE_VRAM_SIZE);
+	memcpy(state->ram, gb->memory.ram + MGB_STATE_RAM_START,
+	       MGB_STATE_RAM_SIZE);
+	if (gb->cartridge.ram_size)
+		memcpy(state + 1, gb->cartridge.ram, gb->cartridge.ram_size);
+	return total;
+}
+
+// Restore a state saved by the same version for the same cartridge,
+// the emulator is left untouched when the state is rejected
+int mgb_load_state(struct gb_emulator *gb, const void *buffer, size_t size)
+{
+	const struct gb_state *state = buffer;
+
+	if (size < sizeof(struct gb_state) ||
+	    state->header.magic != MGB_STATE_MAGIC ||
+	    state->header.version != MGB_STATE_VERSION ||
+	    state->header.type != gb->cartridge.type ||
+	    state->header.ram_size != gb->cartridge.ram_size ||
+	    state->header.size != mgb_state_size(gb) ||
+	    size < state->header.size)
+		return -1;
+	gb_state_load_core(gb, &state->core);
+	memcpy(gb->gpu.frame_buffer, state->frame_buffer,
+	       sizeof(state->frame_buffer));
+	memcpy(gb->memory.ram + MGB_STATE_VRAM_START, state->vram,
+	       MGB_STATE_VRAM_SIZE);
+	memcpy(gb->memory.ram + MGB_STATE_RAM_START, state->ram,
+	       MGB_STATE_RAM_SIZE);
+	if (gb->cartridge.ram_size)
+		memcpy(gb->cartridge.ram, state + 1, gb->cartridge.ram_size);
+	gb_dirty_reset(gb);
+	cartridge_map(&gb->cartridge, &gb->cpu.memory, true);
+	sm83_irq_refresh(&gb->cpu);
+	return 0;
+}
+
+int gb_save_state_file(struct gb_emulator *gb, const char *path)
+{
+	size_t size = mgb_state_size(gb);
+	FILE *file;
+	u8 *buffer;
+	int err = -1;
+
+	if (!(buffer = malloc(size)))
+		return -1;
+	mgb_save_state(gb, buffer, size);
+	if ((file = fopen(path, "wb"))) {
+		if (fwrite(buffer, size, 1, file) == 1)
+			err = 0;
+		fclose(file);
+	}
+	zfree(buffer);
+	return err;
+}
+
+int gb_load_state_file(struct gb_emulator *gb, const char *path)
+{
+	size_t size = mgb_state_size(gb);
+	FILE *file;
+	u8 *buffer;
+	int err = -1;
+
+	if (!(buffer = malloc(size)))
+		return -1;
+	if ((file = fopen(path, "rb"))) {
+		if (fread(buffer, size, 1, file) == 1)
+			err = mgb_load_state(gb, buffer, size);
+		fclose(file);
+	}
+	zfree(buffer);
+	return err;
+}
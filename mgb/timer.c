@@ -1,34 +1,120 @@
 #include "mgb/memory.h"
 #include "mgb/timer.h"
 
-void sm83_update_timer_registers(struct sm83_core *cpu)
-{
-	// Be careful to bypass the reset rule
-	// https://github.com/AntonioND/giibiiadvance/blob/master/docs/TCAGBD.pdf
-	u8 reg_div = cpu->memory.load8(cpu, DIV);
-	u8 reg_tac = cpu->memory.load8(cpu, TAC);
-
-	cpu->internal_divider += cpu->multiplier;
-	if (cpu->internal_divider >= SM83_FREQ / DIV_PERIOD) {
-		cpu->internal_divider -= SM83_FREQ / DIV_PERIOD;
-		reg_div++;
-		cpu->memory.write8(cpu, DIV, reg_div);
-	}
+static const u64 tima_periods[] = {
+	256,
+	4,
+	16,
+	64,
+};
+
+// Bus accesses happen within the current M-cycle, the timer has only
+// counted the previous ones
+static u64 timer_clock(struct sm83_core *cpu)
+{
+	if (cpu->cycles < cpu->multiplier)
+		return 0;
+	return cpu->cycles - cpu->multiplier;
+}
+
+static u8 timer_div(struct sm83_timer *timer, u64 now)
+{
+	return (now - timer->div_epoch) / (SM83_FREQ / DIV_PERIOD);
+}
+
+static u8 timer_tima(struct sm83_timer *timer, u64 now)
+{
+	if (!timer->period)
+		return timer->tima;
+	return timer->tima + (now - timer->tima_epoch) / timer->period;
+}
+
+// Cycles already counted toward the next TIMA increment
+static u64 timer_phase(struct sm83_timer *timer, u64 now)
+{
+	if (!timer->period)
+		return timer->phase;
+	return (now - timer->tima_epoch) % timer->period;
+}
+
+static void timer_schedule(struct sm83_core *cpu, u8 tima, u64 phase, u64 now)
+{
+	struct sm83_timer *timer = &cpu->timer;
+	u8 reg_tac = *sm83_io(cpu, TAC);
+
+	timer->tima = tima;
+	timer->phase = phase;
 	// Is timer disabled
-	if ((reg_tac >> 2) != 1)
+	if (!(reg_tac & 0x4)) {
+		timer->period = 0;
+		timer->overflow = SM83_TIMER_STOPPED;
 		return;
-	u64 period = tima_periods[reg_tac & 3];
-	cpu->internal_timer += cpu->multiplier;
-	while (cpu->internal_timer >= period) {
-		u8 reg_tima = cpu->memory.load8(cpu, TIMA);
-		reg_tima++;
-		cpu->memory.write8(cpu, TIMA, reg_tima);
-		// TIMA overflow
-		if (!reg_tima) {
-			// Request interrupt
-			u8 irq_reqs = cpu->memory.load8(cpu, IF);
-			cpu->memory.write8(cpu, IF, irq_reqs | 1 << IRQ_TIMER);
-		}
-		cpu->internal_timer -= period;
+	}
+	timer->period = tima_periods[reg_tac & 3];
+	timer->tima_epoch = now - phase;
+	timer->overflow = timer->tima_epoch + (256 - tima) * timer->period;
+}
+
+void sm83_timer_reset(struct sm83_core *cpu)
+{
+	cpu->timer.div_epoch = 0;
+	cpu->timer.tima_epoch = 0;
+	cpu->timer.phase = 0;
+	cpu->timer.period = 0;
+	cpu->timer.overflow = SM83_TIMER_STOPPED;
+	cpu->timer.tima = 0;
+}
+
+u8 sm83_timer_load(struct sm83_core *cpu, u16 reg)
+{
+	u64 now = timer_clock(cpu);
+	u8 value;
+
+	if (reg == DIV)
+		value = timer_div(&cpu->timer, now);
+	else
+		value = timer_tima(&cpu->timer, now);
+	// Keep the registers page coherent for raw readers
+	*sm83_io(cpu, reg) = value;
+	return value;
+}
+
+void sm83_timer_write(struct sm83_core *cpu, u16 reg, u8 value)
+{
+	struct sm83_timer *timer = &cpu->timer;
+	u64 now = timer_clock(cpu);
+	u8 tima = timer_tima(timer, now);
+	u64 phase = timer_phase(timer, now);
+
+	switch (reg) {
+	case DIV:
+		// Any write resets the divider
+		timer->div_epoch = now;
+		*sm83_io(cpu, DIV) = 0;
+		return;
+	case TIMA:
+		tima = value;
+		break;
+	}
+	*sm83_io(cpu, reg) = value;
+	timer_schedule(cpu, tima, phase, now);
+}
+
+void sm83_timer_flush(struct sm83_core *cpu)
+{
+	sm83_timer_load(cpu, DIV);
+	sm83_timer_load(cpu, TIMA);
+}
+
+void sm83_timer_overflow(struct sm83_core *cpu)
+{
+	struct sm83_timer *timer = &cpu->timer;
+
+	// Several overflows are due when the core ran ahead of the timer
+	while (cpu->cycles >= timer->overflow) {
+		timer->tima = *sm83_io(cpu, TMA);
+		timer->tima_epoch = timer->overflow;
+		timer->overflow += (256 - timer->tima) * timer->period;
+		sm83_irq_request(cpu, IRQ_TIMER);
 	}
 }
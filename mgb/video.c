@@ -2,19 +2,47 @@
 #include "mgb/mgb.h"
 #include "platform/mm.h"
 #include <stdio.h>
+#include <string.h>
+
+static const int DMG_PALETTE[4] = {
+	DMG_WHITE,
+	DMG_LIGHTGRAY,
+	DMG_DARKGRAY,
+	DMG_BLACK,
+};
+
+// clang-format off
+static const struct vram_area_range vram_areas[][2] = {
+	{
+		{ 0x9800, 0x9BFF },
+		{ 0x9C00, 0x9FFF },
+	},
+	{
+		{ 0x8800, 0x97FF },
+		{ 0x8000, 0x8FFF },
+	},
+	{
+		{ 0x9800, 0x9BFF },
+		{ 0x9C00, 0x9FFF },
+	},
+};
+// clang-format on
 
 void ppu_init(struct ppu *gpu)
 {
 	gpu->frames = 0;
-	gpu->dots = 0;
+	gpu->cycles = 0;
 	ppu_reset(gpu);
 }
 
+// State of a disabled LCD
 void ppu_reset(struct ppu *gpu)
 {
 	gpu->ly = 0;
 	gpu->x = 0;
-	gpu->mode = MODE_1;
+	gpu->dots = 0;
+	gpu->window_line = 0;
+	gpu->mode = MODE_0;
 }
 
 struct addressing {
@@ -22,12 +50,12 @@ struct addressing {
 	u16 index;
 };
 
-static struct addressing get_addressing(struct ppu *gpu, u8 tile_index)
+static struct addressing get_addressing(u8 lcdc, u8 tile_index)
 {
 	struct addressing method = { .offset = 0x8000, .index = tile_index };
 	// Simulate signed indexing
 	// https://gbdev.io/pandocs/Tile_Data.html#vram-tile-data
-	if (!(LCD_CONTROL(LCD_BG_WINDOW_TILE_AREA))) {
+	if (!(FLAG_ENABLE(lcdc, LCD_BG_WINDOW_TILE_AREA))) {
 		if (tile_index > 127) {
 			method.index -= 128;
 			method.offset = 0x8800;
@@ -38,22 +66,22 @@ static struct addressing get_addressing(struct ppu *gpu, u8 tile_index)
 	return method;
 }
 
-static struct vram_area_range current_vram_area_range(struct ppu *gpu,
+static struct vram_area_range current_vram_area_range(u8 lcdc,
 						      enum vram_area area)
 {
 	struct vram_area_range range;
 	switch (area) {
 	case VRAM_AREA_WINDOW_TILEMAP:
 		range = vram_areas[VRAM_AREA_WINDOW_TILEMAP]
-				  [LCD_CONTROL(LCD_BG_TILEMAP_AREA)];
+				  [FLAG_ENABLE(lcdc, LCD_WINDOW_TILEMAP_AREA)];
 		break;
 	case VRAM_AREA_BG_WINDOW_TILE:
 		range = vram_areas[VRAM_AREA_BG_WINDOW_TILE]
-				  [LCD_CONTROL(LCD_BG_WINDOW_TILE_AREA)];
+				  [FLAG_ENABLE(lcdc, LCD_BG_WINDOW_TILE_AREA)];
 		break;
 	case VRAM_AREA_BG_TILEMAP:
 		range = vram_areas[VRAM_AREA_BG_TILEMAP]
-				  [LCD_CONTROL(LCD_BG_TILEMAP_AREA)];
+				  [FLAG_ENABLE(lcdc, LCD_BG_TILEMAP_AREA)];
 		break;
 	}
 	return range;
@@ -70,213 +98,339 @@ static u8 encode_pixel_color(u8 right, u8 left, u8 bit)
 	return pixel;
 }
 
-static void draw_tile(struct ppu *gpu, u8 *vram, int tile_index, int x, int y)
+static u32 shade_rgba(u8 shade)
 {
-	int j = 0;
-	int indice = tile_index * 16;
-
-	for (int b = 0; b < 16; b = b + 2) {
-		int i = 0;
-		u8 right = vram[indice + b];
-		u8 left = vram[indice + b + 1];
-		for (int bit = 7; bit >= 0; bit--) {
-			u8 color = encode_pixel_color(right, left, bit);
-			gpu->renderer.draw(gpu, x * 8 + i, y * 8 + j,
-					   DMG_PALETTE[color]);
-			i++;
-		}
-		j++;
-	}
+	u32 color = DMG_PALETTE[shade];
+	// 0xRRGGBB to R, G, B, A bytes in memory
+	return 0xFF000000 | (color & 0xFF) << 16 | (color & 0xFF00) |
+	       (color >> 16 & 0xFF);
 }
 
-static void push_sprite(struct ppu *gpu, u8 *vram, int tile_index, u8 x, u8 y,
-			bool obj_mode)
+static void blit_tile(const u8 *tile, u32 *pixels, int stride)
 {
-	int j = 0;
-	int indice = tile_index * 16;
-	u8 obj_size = 8;
-
-	if (obj_mode) {
-		obj_size = 16;
-		y -= obj_size;
-	}
-	// y -= obj_size;
-	for (int b = 0; b < (obj_size * 2); b = b + 2) {
-		int i = 0;
-		u8 right = vram[indice + b];
-		u8 left = vram[indice + b + 1];
-		for (int bit = 7; bit >= 0; bit--) {
-			u8 color = encode_pixel_color(right, left, bit);
-			u8 pos_x = x + i;
-			u8 pos_y = y + j;
-			if (color != 0)
-				gpu->frame_buffer[pos_y * GB_WIDTH + pos_x] =
-					color;
-			i++;
+	for (int j = 0; j < GB_TILE_SIZE; j++) {
+		u8 right = tile[j * 2];
+		u8 left = tile[j * 2 + 1];
+		for (int i = 0; i < GB_TILE_SIZE; i++) {
+			u8 color = encode_pixel_color(right, left, 7 - i);
+			pixels[j * stride + i] = shade_rgba(color);
 		}
-		j++;
 	}
 }
 
-static void push_win_bg(struct ppu *gpu, u16 offset, int x, int y)
+// The blit helpers convert copies of the frame buffer and of VRAM
+// (0x8000-0x9FFF), they never touch the PPU itself
+void ppu_blit_frame(const u8 *frame_buffer, u32 *pixels)
 {
-	u8 *tilemap = gpu->ram.offset(gpu, offset);
-	u8 *tiledata = gpu->ram.offset(gpu, 0);
-	for (u8 j = 0; j < GB_HEIGHT / 8; j++) {
-		for (u8 i = 0; i < GB_WIDTH / 8; i++) {
-			int tile_index = tilemap[j * 32 + i];
-			struct addressing method =
-				get_addressing(gpu, tile_index);
-			push_sprite(gpu, tiledata + method.offset, method.index,
-				    i * 8 + (x / 8), j * 8 + (y / 8), 0);
-		}
-	}
+	for (int i = 0; i < GB_HEIGHT * GB_WIDTH; i++)
+		pixels[i] = shade_rgba(frame_buffer[i]);
 }
 
-static void draw_tiledata(struct ppu *gpu, u8 *vram, int x, int y)
+void ppu_blit_tiledata(const u8 *vram, u32 *pixels)
 {
-	for (int j = 0; j <= 23; j++) {
-		for (int i = 0; i < 16; i++) {
-			draw_tile(gpu, vram, (j * 16) + i, i + (x / 8),
-				  j + (y / 8));
+	int columns = GB_TILEDATA_WIDTH / GB_TILE_SIZE;
+	int rows = GB_TILEDATA_HEIGHT / GB_TILE_SIZE;
+
+	for (int j = 0; j < rows; j++) {
+		for (int i = 0; i < columns; i++) {
+			blit_tile(vram + (j * columns + i) *
+						 GB_TILE_MEMORY_SIZE,
+				  pixels + (j * GB_TILEDATA_WIDTH + i) *
+						   GB_TILE_SIZE,
+				  GB_TILEDATA_WIDTH);
 		}
 	}
 }
 
-static void clear_frame(struct ppu *gpu)
+void ppu_blit_tilemap(const u8 *vram, u8 lcdc, enum vram_area area,
+		      u32 *pixels)
 {
-	for (int i = 0; i < ARRAY_SIZE(gpu->frame_buffer); i++)
-		gpu->frame_buffer[i] = 0;
-}
+	struct vram_area_range range = current_vram_area_range(lcdc, area);
+	const u8 *tilemap = vram + range.begin - 0x8000;
+	const u8 *tiledata = vram - 0x8000;
 
-static void draw_oam(struct ppu *gpu)
-{
-	u8 obj_mode = LCD_CONTROL(LCD_OBJ_SIZE);
-	for (int i = 0xFE00; i <= 0xFE9F; i = i + 4) {
-		u8 oam_y = gpu->ram.load(gpu, i) - 8;
-		u8 oam_x = gpu->ram.load(gpu, i + 1) - 8;
-		u8 oam_tile_index = gpu->ram.load(gpu, i + 2);
-		// u8 oam_flags = gpu->memory->array->bytes[i + 3];
-		// bool is_y_flip = FLAG_ENABLE(oam_flags, OAM_Y_FLIP);
-		// bool is_x_flip = FLAG_ENABLE(oam_flags, OAM_X_FLIP);
-		// Object is hide
-		if (oam_y == 0 || oam_y == 160)
-			continue;
-		push_sprite(gpu, gpu->ram.offset(gpu, 0x8000), oam_tile_index,
-			    oam_x, oam_y - 8, obj_mode);
-	}
-}
-
-static void draw_viewport(struct ppu *gpu, int x, int y)
-{
-	struct vram_area_range win_area =
-		current_vram_area_range(gpu, VRAM_AREA_WINDOW_TILEMAP);
-	struct vram_area_range bg_area =
-		current_vram_area_range(gpu, VRAM_AREA_BG_TILEMAP);
-	push_win_bg(gpu, bg_area.begin, x, y);
-	push_win_bg(gpu, win_area.begin, x, y);
-	draw_oam(gpu);
-	for (int j = 0; j < GB_HEIGHT; j++) {
-		for (int i = 0; i < GB_WIDTH; i++) {
-			u8 color = gpu->frame_buffer[j * GB_WIDTH + i];
-			gpu->renderer.draw(gpu, x + i, y + j,
-					   DMG_PALETTE[color]);
+	for (int j = 0; j < GB_TILEMAP_SIZE; j++) {
+		for (int i = 0; i < GB_TILEMAP_SIZE; i++) {
+			struct addressing method = get_addressing(
+				lcdc, tilemap[j * GB_TILEMAP_SIZE + i]);
+			blit_tile(tiledata + method.offset +
+					  method.index * GB_TILE_MEMORY_SIZE,
+				  pixels + (j * GB_BG_MAP_WIDTH + i) *
+						   GB_TILE_SIZE,
+				  GB_BG_MAP_WIDTH);
 		}
 	}
 }
 
 static void update_lyc_ly(struct ppu *gpu)
 {
-	u8 lcd_status = gpu->ram.load(gpu, STAT_LCD);
-	u8 lyc = gpu->ram.load(gpu, LYC_LY);
+	u8 lcd_status = ppu_load(gpu, STAT_LCD);
+	u8 lyc = ppu_load(gpu, LYC_LY);
 	if (lyc == gpu->ly)
 		lcd_status |= 1 << STAT_LYC_LY;
 	else
-		lcd_status ^= 1 << STAT_LYC_LY;
+		lcd_status &= ~(1 << STAT_LYC_LY);
+	ppu_write(gpu, STAT_LCD, lcd_status);
+}
+
+static void set_mode(struct ppu *gpu, enum ppu_mode mode)
+{
+	u8 lcd_status = ppu_load(gpu, STAT_LCD);
+	gpu->mode = mode;
+	ppu_write(gpu, STAT_LCD, (lcd_status & 0xfc) | mode);
 }
 
 static void request_vlank_interrupt(struct ppu *gpu)
 {
-	if (gpu->ly == 144) {
-		u8 irq_reqs = gpu->ram.load(gpu , IF);
-		irq_reqs |= 1 << IRQ_VBLANK;
-		gpu->ram.write(gpu, IF, irq_reqs);
-	}
+	if (gpu->ly == 144)
+		gpu->interrupt(gpu, IRQ_VBLANK);
 }
 
 static void request_stat_interrupt(struct ppu *gpu)
 {
-	if (LCD_STATUS(STAT_LYC_INT_SELECT) && LCD_STATUS(STAT_LYC_LY)) {
-		u8 irq_reqs = gpu->ram.load(gpu , IF);
-		irq_reqs |= 1 << IRQ_LCD;
-		gpu->ram.write(gpu, IF, irq_reqs);
+	if (LCD_STATUS(STAT_LYC_INT_SELECT) && LCD_STATUS(STAT_LYC_LY))
+		gpu->interrupt(gpu, IRQ_LCD);
+}
+
+// Registers latched at the end of mode 3
+struct ppu_registers {
+	u8 lcdc;
+	u8 scy;
+	u8 scx;
+	u8 wy;
+	u8 wx;
+	u8 bgp;
+	u8 obp[2];
+};
+
+static void latch_registers(struct ppu *gpu, struct ppu_registers *regs)
+{
+	regs->lcdc = ppu_load(gpu, LCDC_LCD);
+	regs->scy = ppu_load(gpu, SCY);
+	regs->scx = ppu_load(gpu, SCX);
+	regs->wy = ppu_load(gpu, WY);
+	regs->wx = ppu_load(gpu, WX);
+	regs->bgp = ppu_load(gpu, BGP_BG);
+	regs->obp[0] = ppu_load(gpu, OBP0_OBJ);
+	regs->obp[1] = ppu_load(gpu, OBP1_OBJ);
+}
+
+static u8 palette_shade(u8 palette, u8 color)
+{
+	return (palette >> (color * 2)) & 3;
+}
+
+// Tile data of a BG/window tile, 0x8000 unsigned or 0x9000 signed
+static u8 *bg_tile(u8 *mem, u8 lcdc, u8 tile_index)
+{
+	if (FLAG_ENABLE(lcdc, LCD_BG_WINDOW_TILE_AREA))
+		return mem + 0x8000 + tile_index * GB_TILE_MEMORY_SIZE;
+	return mem + 0x9000 + (s8)tile_index * GB_TILE_MEMORY_SIZE;
+}
+
+static u8 tile_pixel(u8 *tile, u8 row, u8 column)
+{
+	return encode_pixel_color(tile[row * 2], tile[row * 2 + 1],
+				  7 - column);
+}
+
+static void render_tilemap(struct ppu *gpu, u8 *mem, u8 lcdc, u16 tilemap,
+			   u8 map_x, u8 map_y, int x, u8 palette, u8 *colors)
+{
+	u8 *line = gpu->frame_buffer + gpu->ly * GB_WIDTH;
+	u8 *row = mem + tilemap + (map_y / 8) * GB_TILEMAP_SIZE;
+
+	for (; x < GB_WIDTH; x++, map_x++) {
+		u8 *tile = bg_tile(mem, lcdc, row[map_x / 8]);
+		u8 color = tile_pixel(tile, map_y % 8, map_x % 8);
+		colors[x] = color;
+		line[x] = palette_shade(palette, color);
 	}
 }
 
-static void draw_tiles(struct ppu *gpu, u16 offset, int x, int y)
+struct oam_entry {
+	u8 y;
+	u8 x;
+	u8 tile;
+	u8 flags;
+};
+
+static void render_objects(struct ppu *gpu, u8 *mem,
+			   struct ppu_registers *regs, u8 *colors)
 {
-	u8 *tilemap = gpu->ram.offset(gpu, offset);
-	u8 *tiledata = gpu->ram.offset(gpu, 0);
-	for (u8 j = 0; j < 32; j++) {
-		for (u8 i = 0; i < 32; i++) {
-			int tile_index = tilemap[j * 32 + i];
-			struct addressing method =
-				get_addressing(gpu, tile_index);
-			draw_tile(gpu, tiledata + method.offset, method.index,
-				  i + (x / 8), j + (y / 8));
+	struct oam_entry *oam = (struct oam_entry *)(mem + 0xFE00);
+	struct oam_entry *objects[GB_OBJECTS_PER_LINE];
+	u8 *line = gpu->frame_buffer + gpu->ly * GB_WIDTH;
+	u8 height = FLAG_ENABLE(regs->lcdc, LCD_OBJ_SIZE) ? 16 : 8;
+	bool drawn[GB_WIDTH] = { 0 };
+	int count = 0;
+
+	// OAM scan, the first 10 objects overlapping the line are kept
+	for (int i = 0; i < GB_OBJECTS && count < GB_OBJECTS_PER_LINE; i++) {
+		int top = oam[i].y - 16;
+		if (gpu->ly >= top && gpu->ly < top + height)
+			objects[count++] = &oam[i];
+	}
+	// Smaller X first then OAM order, stable insertion sort
+	for (int i = 1; i < count; i++) {
+		struct oam_entry *obj = objects[i];
+		int j = i - 1;
+		for (; j >= 0 && objects[j]->x > obj->x; j--)
+			objects[j + 1] = objects[j];
+		objects[j + 1] = obj;
+	}
+	for (int i = 0; i < count; i++) {
+		struct oam_entry *obj = objects[i];
+		u8 row = gpu->ly - (obj->y - 16);
+		u8 tile_index = obj->tile;
+		u8 palette = regs->obp[FLAG_ENABLE(obj->flags, OAM_DMG_PALETTE)];
+
+		if (height == 16)
+			tile_index &= 0xFE;
+		if (FLAG_ENABLE(obj->flags, OAM_Y_FLIP))
+			row = height - 1 - row;
+		u8 *tile = mem + 0x8000 + tile_index * GB_TILE_MEMORY_SIZE;
+		for (u8 column = 0; column < 8; column++) {
+			int x = obj->x - 8 + column;
+			if (x < 0 || x >= GB_WIDTH || drawn[x])
+				continue;
+			u8 color = tile_pixel(tile, row,
+					      FLAG_ENABLE(obj->flags, OAM_X_FLIP) ?
+						      7 - column :
+						      column);
+			if (!color)
+				continue;
+			// Higher priority object pixels win even when hidden
+			drawn[x] = true;
+			if (FLAG_ENABLE(obj->flags, OAM_PRIORITY) && colors[x])
+				continue;
+			line[x] = palette_shade(palette, color);
 		}
 	}
 }
 
-static void draw_debug_window(struct ppu *gpu, int x, int y)
+static void render_scanline(struct ppu *gpu)
 {
-	struct vram_area_range win_area =
-		current_vram_area_range(gpu, VRAM_AREA_WINDOW_TILEMAP);
-	draw_tiles(gpu, win_area.begin, x, y);
+	struct ppu_registers regs;
+	u8 *mem = gpu->ram.offset(gpu, 0);
+	u8 colors[GB_WIDTH] = { 0 };
+	int window_x;
+
+	gpu->dirty_lines[gpu->ly / 64] |= 1ULL << (gpu->ly % 64);
+	latch_registers(gpu, &regs);
+	if (FLAG_ENABLE(regs.lcdc, LCD_BG_WINDOW_ENABLE)) {
+		u16 bg_map = FLAG_ENABLE(regs.lcdc, LCD_BG_TILEMAP_AREA) ?
+				     0x9C00 :
+				     0x9800;
+		render_tilemap(gpu, mem, regs.lcdc, bg_map, regs.scx,
+			       gpu->ly + regs.scy, 0, regs.bgp, colors);
+		window_x = regs.wx - 7;
+		if (FLAG_ENABLE(regs.lcdc, LCD_WINDOW_ENABLE) &&
+		    gpu->ly >= regs.wy && window_x < GB_WIDTH) {
+			u16 win_map = FLAG_ENABLE(regs.lcdc,
+						  LCD_WINDOW_TILEMAP_AREA) ?
+					      0x9C00 :
+					      0x9800;
+			// Window pixels left of the screen are skipped
+			render_tilemap(gpu, mem, regs.lcdc, win_map,
+				       window_x < 0 ? -window_x : 0,
+				       gpu->window_line,
+				       window_x < 0 ? 0 : window_x, regs.bgp,
+				       colors);
+			gpu->window_line++;
+		}
+	} else {
+		memset(gpu->frame_buffer + gpu->ly * GB_WIDTH, 0, GB_WIDTH);
+	}
+	if (FLAG_ENABLE(regs.lcdc, LCD_OBJ_ENABLE))
+		render_objects(gpu, mem, &regs, colors);
 }
 
-static void draw_debug_background(struct ppu *gpu, int x, int y)
+static void next_scanline(struct ppu *gpu)
 {
-	struct vram_area_range bg_area =
-		current_vram_area_range(gpu, VRAM_AREA_BG_TILEMAP);
-	draw_tiles(gpu, bg_area.begin, x, y);
+	gpu->ly = gpu->ly == GB_VIDEO_VERTICAL_TOTAL_PIXELS - 1 ? 0 : gpu->ly + 1;
+	ppu_write(gpu, LY_LCD, gpu->ly);
+	if (gpu->ly == GB_HEIGHT) {
+		// The frame buffer holds a finished frame
+		gpu->frames++;
+		set_mode(gpu, MODE_1);
+		request_vlank_interrupt(gpu);
+		if (gpu->vblank)
+			gpu->vblank(gpu);
+	} else if (gpu->ly < GB_HEIGHT) {
+		if (!gpu->ly)
+			gpu->window_line = 0;
+		set_mode(gpu, MODE_2);
+	}
+	update_lyc_ly(gpu);
+	request_stat_interrupt(gpu);
 }
 
-void ppu_draw(struct ppu *gpu)
+// Dot at which the current mode ends
+static u64 mode_end(struct ppu *gpu, struct sm83_core *cpu)
 {
-	if (LCD_CONTROL(LCD_ENABLE))
-		draw_viewport(gpu, 0, 0);
-	draw_tiledata(gpu, gpu->ram.offset(gpu, 0x8000), 0, GB_HEIGHT);
-	draw_debug_window(gpu, GB_WIDTH, 0);
-	draw_debug_background(gpu, GB_WIDTH, 256);
-	clear_frame(gpu);
+	switch (gpu->mode) {
+	case MODE_2:
+		return GB_VIDEO_OAM_SCAN_PERIOD / cpu->multiplier;
+	case MODE_3:
+		return (GB_VIDEO_OAM_SCAN_PERIOD + GB_VIDEO_DRAWING_PERIOD) /
+		       cpu->multiplier;
+	default:
+		return GB_VIDEO_SCANLINE_PERIOD / cpu->multiplier;
+	}
 }
 
-static void increment_scanline(struct ppu *gpu, struct sm83_core *cpu)
+void ppu_run(struct ppu *gpu, struct sm83_core *cpu, u32 cycles)
 {
-	if (gpu->ly == 153) {
-		gpu->frames++;
-		ppu_reset(gpu);
-	}
-	if (gpu->dots >= (GB_VIDEO_SCANLINE_PERIOD / cpu->multiplier)) {
-		gpu->dots -= (GB_VIDEO_SCANLINE_PERIOD / cpu->multiplier);
-		u8 ly = gpu->ram.load(gpu, LY_LCD);
-		gpu->ly++;
-		if (gpu->ly == 144 && ly != gpu->ly) {
-			request_vlank_interrupt(gpu);
+	if (!LCD_CONTROL(LCD_ENABLE))
+		return;
+	gpu->dots += cycles;
+	while (gpu->dots >= mode_end(gpu, cpu)) {
+		switch (gpu->mode) {
+		case MODE_2:
+			set_mode(gpu, MODE_3);
+			break;
+		case MODE_3:
+			PROFILE_ENTER(gpu->profile, PROFILE_RENDER);
+			render_scanline(gpu);
+			PROFILE_LEAVE(gpu->profile);
+			set_mode(gpu, MODE_0);
+			break;
+		case MODE_0:
+		case MODE_1:
+			gpu->dots -= GB_VIDEO_SCANLINE_PERIOD / cpu->multiplier;
+			next_scanline(gpu);
+			break;
 		}
-		gpu->ram.write(gpu, LY_LCD, gpu->ly);
-		update_lyc_ly(gpu);
-		request_stat_interrupt(gpu);
 	}
 }
 
-void ppu_tick(struct ppu *gpu, struct sm83_core *cpu)
+void ppu_write_control(struct ppu *gpu, u8 value)
 {
-	if (LCD_CONTROL(LCD_ENABLE)) {
-		gpu->dots += cpu->multiplier;
-		increment_scanline(gpu, cpu);
-	}
+	bool enabled = LCD_CONTROL(LCD_ENABLE);
+
+	ppu_write(gpu, LCDC_LCD, value);
+	if (enabled == (LCD_CONTROL(LCD_ENABLE)))
+		return;
+	// Switching the LCD off or on restarts from line 0
+	ppu_reset(gpu);
+	ppu_write(gpu, LY_LCD, 0);
+	set_mode(gpu, enabled ? MODE_0 : MODE_2);
+	update_lyc_ly(gpu);
+}
+
+void ppu_sync(struct ppu *gpu, struct sm83_core *cpu, u64 now)
+{
+	ppu_run(gpu, cpu, now - gpu->cycles);
+	gpu->cycles = now;
+}
+
+// Cycle of the next mode change, UINT64_MAX while the LCD is off
+u64 ppu_next_event(struct ppu *gpu, struct sm83_core *cpu)
+{
+	if (!LCD_CONTROL(LCD_ENABLE))
+		return UINT64_MAX;
+	return gpu->cycles + mode_end(gpu, cpu) - gpu->dots;
 }
 
 void ppu_info(struct ppu *gpu)
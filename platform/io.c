@@ -1,43 +1,36 @@
 #include "platform/io.h"
-#include "platform/mm.h"
 #include "platform/types.h"
-#include <stdlib.h>
-#include <stdio.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-size_t fs_size(FILE *file)
+// Read-only view of a whole file. Pages come straight from the page
+// cache, every mapping of the same file shares them and nothing is
+// copied until a page is first touched.
+u8 *fs_map(const char *path, size_t *size)
 {
-	size_t size_in_bytes;
-	fseek(file, 0L, SEEK_END);
-	size_in_bytes = ftell(file);
-	fseek(file, 0L, SEEK_SET);
-	return size_in_bytes;
-}
-
-u8 *fs_read(FILE *file, size_t size_in_bytes)
-{
-	u8 *buffer;
+	struct stat st;
+	void *data;
+	int fd;
 
-	if ((buffer = (u8 *)calloc(size_in_bytes, sizeof(u8))) == NULL)
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
 		return NULL;
-	if (fread(buffer, sizeof(u8), size_in_bytes, file) == 0) {
-		zfree(buffer);
+	if (fstat(fd, &st) || st.st_size <= 0) {
+		close(fd);
 		return NULL;
 	}
-	fclose(file);
-	return buffer;
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return NULL;
+	*size = st.st_size;
+	return data;
 }
 
-u8 *readfile(char *path)
+void fs_unmap(u8 *data, size_t size)
 {
-	FILE *file;
-	size_t size_in_bytes;
-	u8 *buffer = NULL;
-
-	file = fopen(path, "r");
-	if (!file)
-		return NULL;
-	size_in_bytes = fs_size(file);
-	if (size_in_bytes > 0)
-		buffer = fs_read(file, size_in_bytes);
-	return buffer;
+	if (data)
+		munmap(data, size);
 }
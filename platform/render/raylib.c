@@ -2,15 +2,42 @@
 #include <raylib.h>
 #include <stdio.h>
 
-static Color convert_color(int color)
+// clang-format off
+static const struct keybind keybindings[] = {
+	{ KEY_Q, BUTTON_A, "A", },
+	{ KEY_W, BUTTON_B, "B", },
+	{ KEY_R, BUTTON_SELECT, "SELECT", },
+	{ KEY_E, BUTTON_START, "START" },
+	{ KEY_RIGHT, BUTTON_RIGHT, "RIGHT" },
+	{ KEY_LEFT, BUTTON_LEFT, "LEFT" },
+	{ KEY_UP, BUTTON_UP, "UP" },
+	{ KEY_DOWN, BUTTON_DOWN, "DOWN" },
+};
+// clang-format on
+
+Texture2D render_texture_create(int width, int height)
+{
+	Image image = GenImageColor(width, height, BLACK);
+	Texture2D texture = LoadTextureFromImage(image);
+	UnloadImage(image);
+	SetTextureFilter(texture, TEXTURE_FILTER_POINT);
+	return texture;
+}
+
+void render_texture_update(Texture2D texture, const u32 *pixels)
+{
+	UpdateTexture(texture, pixels);
+}
+
+void render_texture_draw(Texture2D texture, int x, int y, int scale)
 {
-	int hex_color = (color << 8) | 0xFF;
-	return GetColor(hex_color | 0xFF);
+	Vector2 position = { x * scale, y * scale };
+	DrawTextureEx(texture, position, 0, scale, WHITE);
 }
 
-void render_pixel(int x, int y, int color, int scale)
+void render_texture_release(Texture2D texture)
 {
-	DrawRectangle(x * scale, y * scale, scale, scale, convert_color(color));
+	UnloadTexture(texture);
 }
 
 void log_callback(int msgType, const char *text, va_list args)
@@ -45,6 +72,12 @@ void render_handle_inputs(u8 *keys)
 	*keys = 0;
 }
 
+// Held down to play the game backwards
+bool render_rewind_requested(void)
+{
+	return IsKeyDown(KEY_BACKSPACE);
+}
+
 bool render_is_running(void)
 {
 	return !WindowShouldClose();
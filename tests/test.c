@@ -1,7 +1,16 @@
 #include "platform/mm.h"
+#include "mgb/cartridge.h"
+#include "mgb/emulator.h"
 #include "mgb/joypad.h"
+#include "mgb/rewind.h"
+#include "mgb/scheduler.h"
+#include "mgb/snapshot.h"
+#include "mgb/state.h"
 #include <criterion/criterion.h>
 #include <criterion/new/assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 struct joypad_test_case {
 	u8 keys;
@@ -24,3 +33,736 @@ Test(asserts, native)
 	for (int i = 0; i < ARRAY_SIZE(tests); i++)
 		cr_assert(eq(u8, read_keys(tests[i].keys, tests[i].joyp), tests[i].result));
 }
+
+// Pops every queued event, checking they come out by deadline then enum
+static int scheduler_drain(struct scheduler *sched, enum scheduler_event *order)
+{
+	struct scheduler_entry previous = { 0, 0 };
+	int count = 0;
+
+	while (sched->size) {
+		u64 deadline = scheduler_next(sched);
+		enum scheduler_event event = scheduler_pop(sched);
+
+		cr_assert(ge(u64, deadline, previous.deadline));
+		if (count && deadline == previous.deadline)
+			cr_assert(gt(int, event, previous.event));
+		cr_assert(eq(int, sched->position[event], -1));
+		previous = (struct scheduler_entry){ deadline, event };
+		order[count++] = event;
+	}
+	cr_assert(eq(u64, scheduler_next(sched), SCHEDULER_NEVER));
+	return count;
+}
+
+Test(scheduler, ordering)
+{
+	struct scheduler sched;
+	enum scheduler_event order[EVENT_COUNT];
+
+	scheduler_init(&sched);
+	cr_assert(eq(u64, scheduler_next(&sched), SCHEDULER_NEVER));
+	scheduler_schedule(&sched, EVENT_TIMER, 300);
+	scheduler_schedule(&sched, EVENT_PPU, 100);
+	scheduler_schedule(&sched, EVENT_INPUT, 200);
+	cr_assert(eq(u64, scheduler_next(&sched), 100));
+	cr_assert(eq(int, scheduler_drain(&sched, order), 3));
+	cr_assert(eq(int, order[0], EVENT_PPU));
+	cr_assert(eq(int, order[1], EVENT_INPUT));
+	cr_assert(eq(int, order[2], EVENT_TIMER));
+}
+
+Test(scheduler, same_deadline)
+{
+	struct scheduler sched;
+	enum scheduler_event order[EVENT_COUNT];
+
+	scheduler_init(&sched);
+	scheduler_schedule(&sched, EVENT_INPUT, 50);
+	scheduler_schedule(&sched, EVENT_TIMER, 50);
+	scheduler_schedule(&sched, EVENT_PPU, 50);
+	cr_assert(eq(int, scheduler_drain(&sched, order), 3));
+	cr_assert(eq(int, order[0], EVENT_PPU));
+	cr_assert(eq(int, order[1], EVENT_TIMER));
+	cr_assert(eq(int, order[2], EVENT_INPUT));
+}
+
+Test(scheduler, reschedule)
+{
+	struct scheduler sched;
+	enum scheduler_event order[EVENT_COUNT];
+
+	scheduler_init(&sched);
+	scheduler_schedule(&sched, EVENT_PPU, 100);
+	scheduler_schedule(&sched, EVENT_TIMER, 200);
+	scheduler_schedule(&sched, EVENT_INPUT, 300);
+	// Queued events move instead of being queued twice
+	scheduler_schedule(&sched, EVENT_PPU, 400);
+	scheduler_schedule(&sched, EVENT_INPUT, 10);
+	cr_assert(eq(int, sched.size, 3));
+	cr_assert(eq(u64, scheduler_next(&sched), 10));
+	cr_assert(eq(int, scheduler_drain(&sched, order), 3));
+	cr_assert(eq(int, order[0], EVENT_INPUT));
+	cr_assert(eq(int, order[1], EVENT_TIMER));
+	cr_assert(eq(int, order[2], EVENT_PPU));
+}
+
+Test(scheduler, cancel)
+{
+	struct scheduler sched;
+	enum scheduler_event order[EVENT_COUNT];
+
+	scheduler_init(&sched);
+	scheduler_schedule(&sched, EVENT_PPU, 100);
+	scheduler_schedule(&sched, EVENT_TIMER, 200);
+	scheduler_schedule(&sched, EVENT_INPUT, 300);
+	scheduler_cancel(&sched, EVENT_TIMER);
+	scheduler_cancel(&sched, EVENT_TIMER);
+	// Never is the same as cancelling, like a stopped timer
+	scheduler_schedule(&sched, EVENT_PPU, SCHEDULER_NEVER);
+	cr_assert(eq(int, sched.size, 1));
+	cr_assert(eq(int, scheduler_drain(&sched, order), 1));
+	cr_assert(eq(int, order[0], EVENT_INPUT));
+}
+
+// Every combination of deadlines, rescheduled over the previous one
+Test(scheduler, exhaustive)
+{
+	struct scheduler sched;
+	enum scheduler_event order[EVENT_COUNT];
+	int combinations = 1;
+
+	for (int i = 0; i < EVENT_COUNT; i++)
+		combinations *= 4;
+	scheduler_init(&sched);
+	for (int c = 0; c < combinations; c++) {
+		for (int i = 0, n = c; i < EVENT_COUNT; i++, n /= 4)
+			scheduler_schedule(&sched, i, n % 4);
+		cr_assert(eq(int, sched.size, EVENT_COUNT));
+		for (int i = 0, n = c * 7 + 3; i < EVENT_COUNT; i++, n /= 4)
+			scheduler_schedule(&sched, i, n % 4);
+		cr_assert(eq(int, scheduler_drain(&sched, order), EVENT_COUNT));
+	}
+}
+
+// Banks mapped after each write to the cartridge, -1 when unmapped
+struct cartridge_step {
+	u16 addr;
+	u8 value;
+	int rom0;
+	int romx;
+	int sram;
+};
+
+// clang-format off
+static const struct cartridge_step mbc1_steps[] = {
+	{ 0x0000, 0x0A, 0x00, 0x01,  0 }, // RAM enable
+	{ 0x2000, 0x00, 0x00, 0x01,  0 }, // Bank 0 selects 1
+	{ 0x2000, 0x05, 0x00, 0x05,  0 },
+	{ 0x4000, 0x02, 0x00, 0x45,  0 }, // Upper bits, RAM stays on 0
+	{ 0x2000, 0x20, 0x00, 0x41,  0 }, // Only 5 bits, 0 selects 1
+	{ 0x6000, 0x01, 0x40, 0x41,  2 }, // Mode 1, upper bits on 0x0000 and RAM
+	{ 0x4000, 0x03, 0x60, 0x61,  3 },
+	{ 0x6000, 0x00, 0x00, 0x61,  0 },
+	{ 0x0000, 0x00, 0x00, 0x61, -1 }, // RAM disable
+};
+
+// 32 banks, the upper bits are masked out
+static const struct cartridge_step mbc1_small_steps[] = {
+	{ 0x4000, 0x01, 0x00, 0x01, -1 },
+	{ 0x2000, 0x02, 0x00, 0x02, -1 },
+	{ 0x6000, 0x01, 0x00, 0x02, -1 },
+};
+
+static const struct cartridge_step mbc3_steps[] = {
+	{ 0x2000, 0x00, 0x00, 0x01, -1 }, // RAM disabled at reset
+	{ 0x0000, 0x0A, 0x00, 0x01,  0 },
+	{ 0x2000, 0x7F, 0x00, 0x7F,  0 },
+	{ 0x2000, 0x80, 0x00, 0x01,  0 }, // Only 7 bits, 0 selects 1
+	{ 0x4000, 0x03, 0x00, 0x01,  3 },
+	{ 0x4000, 0x08, 0x00, 0x01, -1 }, // Clock registers
+	{ 0x4000, 0x01, 0x00, 0x01,  1 },
+	{ 0x0000, 0x00, 0x00, 0x01, -1 },
+};
+
+static const struct cartridge_step mbc5_steps[] = {
+	{ 0x2000, 0x00, 0x00, 0x00, -1 }, // Bank 0 is selectable
+	{ 0x0000, 0x0A, 0x00, 0x00,  0 },
+	{ 0x2000, 0xFF, 0x00, 0xFF,  0 },
+	{ 0x3000, 0x01, 0x00, 0x1FF, 0 }, // Ninth bit
+	{ 0x2000, 0x02, 0x00, 0x102, 0 },
+	{ 0x3000, 0x00, 0x00, 0x02,  0 },
+	{ 0x4000, 0x0F, 0x00, 0x02, 15 },
+	{ 0x4000, 0x13, 0x00, 0x02,  3 }, // Masked to the RAM size
+	{ 0x1000, 0x00, 0x00, 0x02, -1 },
+};
+// clang-format on
+
+static int mapped_bank(u8 *page, u8 *base, size_t size)
+{
+	return page ? (page - base) / size : -1;
+}
+
+static void cartridge_run(enum cartridge_controller controller,
+			  u16 rom_banks, u8 ram_banks,
+			  const struct cartridge_step *steps, int count)
+{
+	struct cartridge cart = { 0 };
+	struct sm83_memory memory = { 0 };
+	const int rom0 = 0x0000 >> MEMORY_PAGE_SHIFT;
+	const int romx = CARTRIDGE_ROM_BANK_SIZE >> MEMORY_PAGE_SHIFT;
+	const int sram = CARTRIDGE_RAM_START >> MEMORY_PAGE_SHIFT;
+
+	cart.controller = controller;
+	cart.rom_banks = rom_banks;
+	cart.rom_size = (size_t)rom_banks * CARTRIDGE_ROM_BANK_SIZE;
+	cart.rom = calloc(cart.rom_size, 1);
+	cart.ram_banks = ram_banks;
+	cart.ram_size = (size_t)ram_banks * CARTRIDGE_RAM_BANK_SIZE;
+	cart.ram = ram_banks ? calloc(cart.ram_size, 1) : NULL;
+	cr_assert(not(zero(ptr, cart.rom)));
+	cartridge_reset(&cart);
+	cartridge_map(&cart, &memory, true);
+	for (int i = 0; i < count; i++) {
+		cartridge_write(&cart, steps[i].addr, steps[i].value);
+		cartridge_map(&cart, &memory, false);
+		cr_assert(eq(int, mapped_bank(memory.load_pages[rom0], cart.rom,
+					      CARTRIDGE_ROM_BANK_SIZE),
+			     steps[i].rom0));
+		cr_assert(eq(int, mapped_bank(memory.load_pages[romx], cart.rom,
+					      CARTRIDGE_ROM_BANK_SIZE),
+			     steps[i].romx));
+		cr_assert(eq(int, mapped_bank(memory.load_pages[sram], cart.ram,
+					      CARTRIDGE_RAM_BANK_SIZE),
+			     steps[i].sram));
+		// ROM is never writable, RAM only once enabled
+		cr_assert(zero(ptr, memory.write_pages[romx]));
+		cr_assert(eq(ptr, memory.write_pages[sram],
+			     memory.load_pages[sram]));
+	}
+	cartridge_release(&cart);
+}
+
+Test(cartridge, mbc1)
+{
+	cartridge_run(CONTROLLER_MBC1, 128, 4, mbc1_steps,
+		      ARRAY_SIZE(mbc1_steps));
+	cartridge_run(CONTROLLER_MBC1, 32, 0, mbc1_small_steps,
+		      ARRAY_SIZE(mbc1_small_steps));
+}
+
+Test(cartridge, mbc3)
+{
+	cartridge_run(CONTROLLER_MBC3, 128, 4, mbc3_steps,
+		      ARRAY_SIZE(mbc3_steps));
+}
+
+Test(cartridge, mbc5)
+{
+	cartridge_run(CONTROLLER_MBC5, 512, 16, mbc5_steps,
+		      ARRAY_SIZE(mbc5_steps));
+}
+
+Test(cartridge, mbc3_clock)
+{
+	struct cartridge cart = { .controller = CONTROLLER_MBC3 };
+
+	cartridge_reset(&cart);
+	cartridge_write(&cart, 0x4000, 0x08);
+	cartridge_write_ram(&cart, CARTRIDGE_RAM_START, 0x2A);
+	cr_assert(eq(u8, cartridge_load_ram(&cart, CARTRIDGE_RAM_START), 0xFF));
+	cartridge_write(&cart, 0x0000, 0x0A);
+	cartridge_write_ram(&cart, CARTRIDGE_RAM_START, 0x2A);
+	cr_assert(eq(u8, cartridge_load_ram(&cart, CARTRIDGE_RAM_START), 0x2A));
+	cr_assert(eq(u8, cart.regs.rtc[0], 0x2A));
+	cartridge_write(&cart, 0x4000, 0x0C);
+	cr_assert(eq(u8, cartridge_load_ram(&cart, CARTRIDGE_RAM_START), 0x00));
+}
+
+// Turns the LCD on then stores DIV to WRAM, cartridge RAM and HRAM
+// forever, HL cycles through 0xC000-0xCFFF
+// clang-format off
+static const u8 test_program[] = {
+	0x3E, 0x91,		// LD A, 0x91
+	0xE0, 0x40,		// LDH (0x40), A
+	0x3E, 0x0A,		// LD A, 0x0A
+	0xEA, 0x00, 0x00,	// LD (0x0000), A
+	0x21, 0x00, 0xC0,	// LD HL, 0xC000
+	0xF0, 0x04,		// LDH A, (0x04)
+	0x22,			// LD (HL+), A
+	0xCB, 0xA4,		// RES 4, H
+	0xEA, 0x00, 0xA0,	// LD (0xA000), A
+	0xE0, 0x80,		// LDH (0x80), A
+	0x18, 0xF4,		// JR -12
+};
+// clang-format on
+
+static struct gb_emulator *test_emulator(void)
+{
+	char path[] = "/tmp/mgb-test-XXXXXX";
+	size_t size = 2 * CARTRIDGE_ROM_BANK_SIZE;
+	struct gb_emulator *gb;
+	u8 *rom;
+	int fd;
+
+	rom = calloc(size, 1);
+	cr_assert(not(zero(ptr, rom)));
+	memcpy(rom + 0x100, test_program, sizeof(test_program));
+	rom[CARTRIDGE_TYPE] = 0x03; // MBC1+RAM+BATTERY
+	rom[CARTRIDGE_RAM_SIZE] = 0x02; // 8KB
+	fd = mkstemp(path);
+	cr_assert(ge(int, fd, 0));
+	cr_assert(write(fd, rom, size) == (ssize_t)size);
+	close(fd);
+	gb = mgb_create(path);
+	unlink(path);
+	free(rom);
+	cr_assert(not(zero(ptr, gb)));
+	return gb;
+}
+
+static u8 *state_save(struct gb_emulator *gb, size_t *size)
+{
+	u8 *buffer;
+
+	*size = mgb_state_size(gb);
+	buffer = malloc(*size);
+	cr_assert(not(zero(ptr, buffer)));
+	cr_assert(eq(sz, mgb_save_state(gb, buffer, *size), *size));
+	return buffer;
+}
+
+Test(state, roundtrip)
+{
+	struct gb_emulator *gb = test_emulator();
+	struct gb_emulator *other = test_emulator();
+	u8 *first, *second;
+	size_t size;
+
+	mgb_run_cycles(gb, GB_VIDEO_FRAME_PERIOD + 1234);
+	first = state_save(gb, &size);
+	// Into a fresh emulator and back
+	cr_assert(eq(int, mgb_load_state(other, first, size), 0));
+	second = state_save(other, &size);
+	cr_assert(zero(int, memcmp(first, second, size)));
+	free(second);
+	// Over a machine that kept running
+	mgb_run_cycles(gb, GB_VIDEO_FRAME_PERIOD);
+	cr_assert(eq(int, mgb_load_state(gb, first, size), 0));
+	second = state_save(gb, &size);
+	cr_assert(zero(int, memcmp(first, second, size)));
+	free(second);
+	// Both run the same afterwards
+	mgb_run_cycles(gb, GB_VIDEO_FRAME_PERIOD);
+	mgb_run_cycles(other, GB_VIDEO_FRAME_PERIOD);
+	free(first);
+	first = state_save(gb, &size);
+	second = state_save(other, &size);
+	cr_assert(zero(int, memcmp(first, second, size)));
+	free(first);
+	free(second);
+	mgb_destroy(gb);
+	mgb_destroy(other);
+}
+
+Test(state, rejected)
+{
+	struct gb_emulator *gb = test_emulator();
+	struct gb_state *state;
+	u8 *saved, *current;
+	size_t size;
+
+	mgb_run_cycles(gb, GB_VIDEO_FRAME_PERIOD);
+	saved = state_save(gb, &size);
+	state = (struct gb_state *)saved;
+	mgb_run_cycles(gb, GB_VIDEO_FRAME_PERIOD);
+	current = state_save(gb, &size);
+	state->header.version++;
+	cr_assert(eq(int, mgb_load_state(gb, saved, size), -1));
+	state->header.version--;
+	state->header.magic ^= 1;
+	cr_assert(eq(int, mgb_load_state(gb, saved, size), -1));
+	state->header.magic ^= 1;
+	cr_assert(eq(int, mgb_load_state(gb, saved, size - 1), -1));
+	// Nothing was loaded
+	free(saved);
+	saved = state_save(gb, &size);
+	cr_assert(zero(int, memcmp(saved, current, size)));
+	free(saved);
+	free(current);
+	mgb_destroy(gb);
+}
+
+Test(snapshot, withheld_pages)
+{
+	struct gb_emulator *gb = test_emulator();
+	struct gb_snapshot *first, *second;
+	u8 *before, *middle, *after;
+	size_t size;
+
+	mgb_run_cycles(gb, GB_VIDEO_FRAME_PERIOD);
+	first = gb_snapshot_take(gb);
+	cr_assert(not(zero(ptr, first)));
+	before = state_save(gb, &size);
+	// WRAM goes back to the CPU on its first write
+	for (int i = 0xC0; i < 0xE0; i++)
+		cr_assert(zero(ptr, gb->cpu.memory.write_pages[i]));
+	mgb_run_cycles(gb, GB_VIDEO_FRAME_PERIOD);
+	cr_assert(not(zero(ptr, gb->cpu.memory.write_pages[0xC0])));
+	second = gb_snapshot_take(gb);
+	cr_assert(not(zero(ptr, second)));
+	cr_assert(eq(ptr, second->parent, first));
+	middle = state_save(gb, &size);
+	mgb_run_cycles(gb, 2 * GB_VIDEO_FRAME_PERIOD);
+	cr_assert(eq(int, gb_snapshot_restore(gb, first), 0));
+	after = state_save(gb, &size);
+	cr_assert(zero(int, memcmp(before, after, size)));
+	free(after);
+	// Pages are withheld again and the run is the same
+	cr_assert(zero(ptr, gb->cpu.memory.write_pages[0xC0]));
+	mgb_run_cycles(gb, GB_VIDEO_FRAME_PERIOD);
+	after = state_save(gb, &size);
+	cr_assert(zero(int, memcmp(middle, after, size)));
+	free(after);
+	mgb_run_cycles(gb, GB_VIDEO_FRAME_PERIOD);
+	cr_assert(eq(int, gb_snapshot_restore(gb, second), 0));
+	after = state_save(gb, &size);
+	cr_assert(zero(int, memcmp(middle, after, size)));
+	free(after);
+	free(before);
+	free(middle);
+	gb_snapshot_release(second);
+	gb_snapshot_release(first);
+	mgb_destroy(gb);
+}
+
+// Encodes a against b then checks the delta takes b back to a
+static size_t delta_roundtrip(const u8 *a, const u8 *b, size_t size)
+{
+	u8 *delta = malloc(rewind_delta_bound(size));
+	u8 *state = malloc(size);
+	size_t length;
+
+	cr_assert(not(zero(ptr, delta)));
+	cr_assert(not(zero(ptr, state)));
+	length = rewind_delta_encode(a, b, size, delta);
+	cr_assert(le(sz, length, rewind_delta_bound(size)));
+	memcpy(state, b, size);
+	rewind_delta_apply(state, delta, length);
+	cr_assert(zero(int, memcmp(state, a, size)));
+	free(delta);
+	free(state);
+	return length;
+}
+
+Test(rewind, delta)
+{
+	size_t size = 0x3000;
+	u8 *a = malloc(size);
+	u8 *b = malloc(size);
+
+	cr_assert(not(zero(ptr, a)));
+	cr_assert(not(zero(ptr, b)));
+	srand(1);
+	for (size_t i = 0; i < size; i++)
+		a[i] = b[i] = rand();
+	cr_assert(eq(sz, delta_roundtrip(a, b, size), 4));
+	// Changed bytes apart by less than, then exactly DELTA_MIN_ZEROS
+	for (size_t i = 0x100; i < 0x200; i += 3)
+		b[i] ^= 0x5A;
+	for (size_t i = 0x800; i < 0x900; i += 5)
+		b[i] ^= 0xA5;
+	b[0] ^= 1;
+	b[size - 1] ^= 1;
+	delta_roundtrip(a, b, size);
+	for (size_t i = 0; i < size; i++)
+		b[i] = rand();
+	delta_roundtrip(a, b, size);
+	free(a);
+	free(b);
+}
+
+Test(rewind, long_runs)
+{
+	size_t size = 3 * 0xFFFF + 5;
+	u8 *a = calloc(size, 1);
+	u8 *b = calloc(size, 1);
+
+	cr_assert(not(zero(ptr, a)));
+	cr_assert(not(zero(ptr, b)));
+	// Unchanged and changed runs are both split every 0xFFFF bytes
+	cr_assert(eq(sz, delta_roundtrip(a, b, size), 4 * 4));
+	memset(b, 0xFF, size);
+	cr_assert(eq(sz, delta_roundtrip(a, b, size), 4 * 4 + size));
+	memset(b + 0x100, 0, 0x20000);
+	delta_roundtrip(a, b, size);
+	free(a);
+	free(b);
+}
+
+// Records frames frames, keeping each state in states
+static struct gb_emulator *rewind_record(struct rewind *rw, u32 capacity,
+					 size_t arena_size, u8 **states,
+					 int frames)
+{
+	struct gb_emulator *gb = test_emulator();
+	size_t size;
+
+	cr_assert(eq(int, rewind_init(rw, gb, capacity, arena_size), 0));
+	for (int i = 0; i < frames; i++) {
+		mgb_run_cycles(gb, GB_VIDEO_FRAME_PERIOD);
+		rewind_push(rw, gb);
+		states[i] = state_save(gb, &size);
+	}
+	return gb;
+}
+
+static void rewind_check(struct rewind *rw, struct gb_emulator *gb,
+			 u8 **states, int frame)
+{
+	size_t size;
+	u8 *state = state_save(gb, &size);
+
+	cr_assert(zero(int, memcmp(state, states[frame], size)));
+	free(state);
+}
+
+Test(rewind, eviction)
+{
+	u8 *states[32];
+	struct rewind rw;
+	struct gb_emulator *gb;
+	u32 count;
+
+	// Room for a few deltas only
+	gb = rewind_record(&rw, 64, 0x2000, states, ARRAY_SIZE(states));
+	cr_assert(gt(u32, rw.count, 0));
+	cr_assert(lt(u32, rw.count, ARRAY_SIZE(states) - 1));
+	for (u32 i = 0; i < rw.count; i++) {
+		struct rewind_entry *entry =
+			&rw.entries[(rw.head + rw.capacity - 1 - i) % rw.capacity];
+		cr_assert(le(sz, entry->offset + entry->size, rw.arena_size));
+	}
+	// The records left are the newest ones and still apply
+	count = rw.count;
+	for (u32 i = 1; i <= count; i++) {
+		cr_assert(eq(u32, rewind_step(&rw, gb, 1), 1));
+		rewind_check(&rw, gb, states, ARRAY_SIZE(states) - 1 - i);
+	}
+	cr_assert(eq(u32, rewind_step(&rw, gb, 1), 0));
+	for (int i = 0; i < ARRAY_SIZE(states); i++)
+		free(states[i]);
+	rewind_release(&rw);
+	mgb_destroy(gb);
+}
+
+Test(rewind, oldest)
+{
+	u8 *states[10];
+	struct rewind rw;
+	struct gb_emulator *gb;
+
+	gb = rewind_record(&rw, 4, 0x100000, states, ARRAY_SIZE(states));
+	cr_assert(eq(u32, rw.count, 4));
+	rewind_check(&rw, gb, states, 9);
+	// Going further back than recorded stops at the oldest frame
+	cr_assert(eq(u32, rewind_step(&rw, gb, 100), 4));
+	rewind_check(&rw, gb, states, 5);
+	cr_assert(eq(u32, rewind_step(&rw, gb, 1), 0));
+	rewind_check(&rw, gb, states, 5);
+	// Recording starts again from there
+	mgb_run_cycles(gb, GB_VIDEO_FRAME_PERIOD);
+	rewind_push(&rw, gb);
+	cr_assert(eq(u32, rewind_step(&rw, gb, 2), 1));
+	rewind_check(&rw, gb, states, 5);
+	for (int i = 0; i < ARRAY_SIZE(states); i++)
+		free(states[i]);
+	rewind_release(&rw);
+	mgb_destroy(gb);
+}
+
+#define ALU_HL 0x8000
+
+// Core running out of a flat 64KB memory, pages are all directly mapped
+struct alu_machine {
+	struct sm83_core cpu;
+	u8 memory[MEMORY_SIZE];
+};
+
+static struct alu_machine *alu_create(void)
+{
+	struct alu_machine *m = calloc(1, sizeof(struct alu_machine));
+
+	cr_assert(not(zero(ptr, m)));
+	sm83_cpu_reset(&m->cpu);
+	for (int i = 0; i < MEMORY_PAGE_COUNT; i++) {
+		m->cpu.memory.load_pages[i] = m->memory + i * MEMORY_PAGE_SIZE;
+		m->cpu.memory.write_pages[i] = m->memory + i * MEMORY_PAGE_SIZE;
+	}
+	m->cpu.memory.io = m->memory + 0xFF00;
+	return m;
+}
+
+// Operand r of the register forms: B, C, D, E, H, L, (HL) then A
+static u8 *alu_register(struct alu_machine *m, int r)
+{
+	u8 *registers[] = { &m->cpu.b, &m->cpu.c, &m->cpu.d,
+			    &m->cpu.e, &m->cpu.h, &m->cpu.l,
+			    m->memory + ALU_HL, &m->cpu.a };
+
+	return registers[r];
+}
+
+// Runs opcode, followed by DAA if daa, r < 0 takes an immediate operand
+static void alu_run(struct alu_machine *m, u8 opcode, int r, u8 a,
+		    u8 operand, bool carry, bool daa)
+{
+	u8 *pc = m->memory;
+
+	*pc++ = opcode;
+	if (r < 0)
+		*pc++ = operand;
+	*pc = 0x27;
+	m->cpu.pc = 0;
+	m->cpu.hl = ALU_HL;
+	m->cpu.a = a;
+	if (r >= 0)
+		*alu_register(m, r) = operand;
+	cpu_flag_set(&m->cpu, carry ? FLAG_C : FLAG_NONE);
+	sm83_cpu_run_instruction(&m->cpu);
+	if (daa)
+		sm83_cpu_run_instruction(&m->cpu);
+}
+
+// ADD, ADC, SUB, SBC, AND, XOR, OR then CP as in the opcode bits 3-5
+static u8 alu_reference(int op, u8 a, u8 b, bool carry, u8 *f)
+{
+	int c = (op == 1 || op == 3) && carry;
+	int result;
+
+	switch (op) {
+	case 0:
+	case 1:
+		result = a + b + c;
+		*f = ((a & 0xF) + (b & 0xF) + c > 0xF ? FLAG_H : 0) |
+		     (result > 0xFF ? FLAG_C : 0);
+		break;
+	case 2:
+	case 3:
+	case 7:
+		result = a - b - c;
+		*f = FLAG_N | ((a & 0xF) < (b & 0xF) + c ? FLAG_H : 0) |
+		     (result < 0 ? FLAG_C : 0);
+		break;
+	case 4:
+		result = a & b;
+		*f = FLAG_H;
+		break;
+	case 5:
+		result = a ^ b;
+		*f = 0;
+		break;
+	default:
+		result = a | b;
+		*f = 0;
+		break;
+	}
+	if ((u8)result == 0)
+		*f |= FLAG_Z;
+	return op == 7 ? a : result;
+}
+
+static u8 daa_reference(u8 a, u8 *f)
+{
+	u8 adjust = 0;
+
+	if (*f & FLAG_N) {
+		adjust |= *f & FLAG_C ? 0x60 : 0;
+		adjust |= *f & FLAG_H ? 0x06 : 0;
+		a -= adjust;
+	} else {
+		if ((*f & FLAG_C) || a > 0x99) {
+			adjust |= 0x60;
+			*f |= FLAG_C;
+		}
+		if ((*f & FLAG_H) || (a & 0xF) > 9)
+			adjust |= 0x06;
+		a += adjust;
+	}
+	*f = (*f & (FLAG_N | FLAG_C)) | (a ? 0 : FLAG_Z);
+	return a;
+}
+
+static void alu_check(struct alu_machine *m, u8 opcode, u8 a, u8 operand,
+		      bool carry, u8 value, u8 expected, u8 f)
+{
+	u8 flags = sm83_flags(&m->cpu);
+
+	if (value == expected && flags == f)
+		return;
+	cr_assert_fail("%02X with A=%02X operand=%02X carry=%d gives "
+		       "%02X F=%02X instead of %02X F=%02X",
+		       opcode, a, operand, carry, value, flags, expected, f);
+}
+
+Test(alu, arithmetic)
+{
+	struct alu_machine *m = alu_create();
+
+	for (int op = 0; op < 8; op++) {
+		for (int r = -1; r < 8; r++) {
+			u8 opcode = r < 0 ? 0xC6 | op << 3 : 0x80 | op << 3 | r;
+
+			for (int i = 0; i < 0x20000; i++) {
+				u8 a = i, b = i >> 8, f, result;
+				bool carry = i >> 16;
+
+				if (r == 7 && a != b)
+					continue;
+				result = alu_reference(op, a, b, carry, &f);
+				alu_run(m, opcode, r, a, b, carry, false);
+				alu_check(m, opcode, a, b, carry, m->cpu.a,
+					  result, f);
+				result = daa_reference(result, &f);
+				alu_run(m, opcode, r, a, b, carry, true);
+				alu_check(m, opcode, a, b, carry, m->cpu.a,
+					  result, f);
+			}
+		}
+	}
+	free(m);
+}
+
+Test(alu, increment)
+{
+	struct alu_machine *m = alu_create();
+
+	for (int dec = 0; dec < 2; dec++) {
+		for (int r = 0; r < 8; r++) {
+			u8 opcode = (dec ? 0x05 : 0x04) | r << 3;
+
+			for (int i = 0; i < 0x20000; i++) {
+				u8 a = i, x = i >> 8, result;
+				bool carry = i >> 16;
+				u8 f = carry ? FLAG_C : 0;
+
+				if (r == 7 && a != x)
+					continue;
+				result = dec ? x - 1 : x + 1;
+				if (dec)
+					f |= FLAG_N | ((x & 0xF) == 0 ? FLAG_H : 0);
+				else
+					f |= (x & 0xF) == 0xF ? FLAG_H : 0;
+				f |= result ? 0 : FLAG_Z;
+				alu_run(m, opcode, r, a, x, carry, false);
+				alu_check(m, opcode, a, x, carry,
+					  *alu_register(m, r), result, f);
+				result = daa_reference(r == 7 ? result : a, &f);
+				alu_run(m, opcode, r, a, x, carry, true);
+				alu_check(m, opcode, a, x, carry, m->cpu.a,
+					  result, f);
+			}
+		}
+	}
+	free(m);
+}